@@ -0,0 +1,294 @@
+#include "adaptive.hpp"
+#include "binned.hpp"
+#include "dotk.hpp"
+#include "merge.hpp"
+#include "fma.hpp"
+#include "gemm.hpp"
+#include "kobbelt.hpp"
+#include "long_accumulator.hpp"
+#include "narrow.hpp"
+#include "pichat.hpp"
+#include "sorting.hpp"
+#include "cpu_dispatch.hpp"
+#include "parallel.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+using namespace std;
+
+// Бенчмарк: все алгоритмы × размеры 10..max-size × распределения входа из
+// tests/tests.cpp. Результат — JSON в stdout, ход прогона — в stderr.
+//
+//   dot_product_bench [--max-size N] [--min-time SECONDS]
+//
+// Отдельно — GEMV квадратной матрицы GEMV_SIZE × GEMV_SIZE по строкам и по
+// столбцам против построчного цикла merge_dot_product.
+
+struct Input {
+    vector<double> a;
+    vector<double> b;
+};
+
+// Распределения повторяют тесты 1, 2, 5 и 8 из tests/tests.cpp,
+// обобщённые на произвольную длину n, плюс типичные данные из нескольких
+// десятков двоичных порядков
+// Пары ±1e308 взаимно уничтожаются, точный результат — хвост 1e-20.
+// При чётном n пар (n - 2) / 2, а лишний элемент перед хвостом — ноль.
+static Input make_cancellation(size_t n, mt19937_64&){
+    Input in{vector<double>(n, 0.0), vector<double>(n, 1.0)};
+    size_t paired = (n - 1) / 2 * 2;
+    for (size_t i = 0; i < paired; i++) in.a[i] = i % 2 == 0 ? 1e308 : -1e308;
+    in.a[n - 1] = 1e-10;                        // маленький хвост
+    in.b[n - 1] = 1e-10;
+    return in;
+}
+
+static double rnd_pow2(mt19937_64& rng, int exp_min, int exp_max){
+    uniform_real_distribution<> uni01(0.0, 1.0);
+    int e = uniform_int_distribution<int>(exp_min, exp_max)(rng);
+    double m = ldexp(uni01(rng) + 1.0, -1);
+    return copysign(ldexp(m, e), rng() & 1 ? 1.0 : -1.0);
+}
+
+static Input make_subnormals(size_t n, mt19937_64& rng){
+    Input in{vector<double>(n), vector<double>(n)};
+    for (size_t i = 0; i < n; i++){
+        in.a[i] = rnd_pow2(rng, -1022, 1023);
+        in.b[i] = rnd_pow2(rng, -1074, -1022);
+    }
+    return in;
+}
+
+static Input make_log_uniform(size_t n, mt19937_64& rng){
+    Input in{vector<double>(n), vector<double>(n)};
+    for (size_t i = 0; i < n; i++){
+        in.a[i] = rnd_pow2(rng, -1022, 1023);
+        in.b[i] = rnd_pow2(rng, -1022, 1023);
+    }
+    return in;
+}
+
+static Input make_narrow(size_t n, mt19937_64& rng){
+    Input in{vector<double>(n), vector<double>(n)};
+    for (size_t i = 0; i < n; i++){
+        in.a[i] = rnd_pow2(rng, -20, 20);
+        in.b[i] = rnd_pow2(rng, -20, 20);
+    }
+    return in;
+}
+
+static Input make_big_tiny(size_t n, mt19937_64&){
+    Input in{vector<double>(n), vector<double>(n)};
+    for (size_t i = 0; i < n; i++){
+        bool first_half = i < n / 2;
+        in.a[i] = first_half ? 1.0e150 : -1.0e150;
+        in.b[i] = first_half ? 1.0e-150 : -1.0e-150;
+    }
+    return in;
+}
+
+struct Distribution {
+    const char* name;
+    Input (*make)(size_t, mt19937_64&);
+};
+
+static double merge_mt(DotView a, DotView b){ return merge_dot_product_parallel(a, b); }
+static double kobbelt_mt(DotView a, DotView b){ return kobbelt_dot_product_parallel(a, b); }
+static double long_mt(DotView a, DotView b){ return long_accumulator_dot_product_parallel(a, b); }
+static double binned_mt(DotView a, DotView b){ return binned_dot_product_parallel(a, b); }
+
+struct Algorithm {
+    const char* name;
+    double (*run)(DotView, DotView);
+};
+
+// Расстояние до точного результата в ulp точного результата; null в JSON,
+// если результат или точное значение не конечны и не совпадают
+static bool ulp_error(double result, double exact, double& ulps){
+    if (!isfinite(result) || !isfinite(exact)){
+        ulps = 0.0;
+        return memcmp(&result, &exact, sizeof(double)) == 0 || (isnan(result) && isnan(exact));
+    }
+    int exp = exact == 0.0 ? -1074 : max(ilogb(exact) - 52, -1074);
+    ulps = fabs(result - exact) / ldexp(1.0, exp);
+    if (isinf(ulps)) return false;
+    return true;
+}
+
+static uint64_t read_cycles(){
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Timing {
+    double seconds = INFINITY;
+    uint64_t cycles = 0;
+    size_t repetitions = 0;
+};
+
+// Повторяем до min_time; берём лучший прогон — он меньше всего искажён
+// прерываниями и соседними процессами
+template<class Run>
+static Timing measure(double min_time, Run run){
+    Timing best;
+    double total = 0.0;
+    do {
+        auto start = chrono::steady_clock::now();
+        uint64_t cycles_start = read_cycles();
+        run();
+        uint64_t cycles = read_cycles() - cycles_start;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (seconds < best.seconds){
+            best.seconds = seconds;
+            best.cycles = cycles;
+        }
+        total += seconds;
+        best.repetitions++;
+    } while (total < min_time);
+    return best;
+}
+
+const size_t GEMV_SIZE = 4000;
+
+// y = A·x для A из узкого распределения: gemv в обоих режимах и цикл
+// merge_dot_product по строкам. Время — на элемент A
+static void bench_gemv(double min_time){
+    mt19937_64 rng(20250423);
+    const size_t n = GEMV_SIZE;
+    Input in = make_narrow(n * n, rng);
+    vector<double> x(in.b.begin(), in.b.begin() + n), y(n);
+    vector<double> by_columns(n * n);
+    for (size_t i = 0; i < n; i++){
+        for (size_t k = 0; k < n; k++) by_columns[k * n + i] = in.a[i * n + k];
+    }
+    struct Layout {
+        const char* name;
+        MatrixView a;
+    };
+    const Layout layouts[] = {
+        {"rows", MatrixView(in.a.data(), n, n)},
+        {"columns", MatrixView(by_columns.data(), n, n, 1, (ptrdiff_t)n)},
+    };
+    bool first = true;
+    printf(",\n  \"gemv\": [");
+    for (const Layout& layout : layouts){
+        const MatrixView a = layout.a;
+        struct Variant {
+            const char* name;
+            function<void()> run;
+        };
+        const Variant variants[] = {
+            {"GEMV", [&]{ gemv(a, DotView(x), y.data(), 1, GemmMode::Compensated, 1); }},
+            {"GEMV Exact", [&]{ gemv(a, DotView(x), y.data(), 1, GemmMode::Exact, 1); }},
+            {"Merge rows", [&]{ for (size_t i = 0; i < n; i++) y[i] = merge_dot_product(a.row(i), DotView(x)); }},
+        };
+        for (const Variant& variant : variants){
+            fprintf(stderr, "gemv %s %s\n", layout.name, variant.name);
+            Timing t = measure(min_time, variant.run);
+            printf("%s\n    {\"algorithm\": \"%s\", \"layout\": \"%s\", \"rows\": %zu, \"cols\": %zu, "
+                   "\"ns_per_element\": %.4g, \"gb_per_s\": %.4g, \"cycles_per_element\": %.4g, "
+                   "\"repetitions\": %zu}",
+                   first ? "" : ",", variant.name, layout.name, n, n,
+                   t.seconds * 1e9 / (n * n), sizeof(double) * n * n / t.seconds * 1e-9,
+                   (double)t.cycles / (n * n), t.repetitions);
+            first = false;
+            fflush(stdout);
+        }
+    }
+    printf("\n  ]");
+}
+
+int main(int argc, char** argv){
+    size_t max_size = 100000000;
+    double min_time = 0.2;
+    for (int i = 1; i < argc; i++){
+        if (!strcmp(argv[i], "--max-size") && i + 1 < argc) max_size = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) min_time = strtod(argv[++i], nullptr);
+        else {
+            fprintf(stderr, "usage: %s [--max-size N] [--min-time SECONDS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const Distribution distributions[] = {
+        {"cancellation", make_cancellation},
+        {"subnormals", make_subnormals},
+        {"log_uniform", make_log_uniform},
+        {"big_tiny", make_big_tiny},
+        {"narrow", make_narrow},
+    };
+    const Algorithm algorithms[] = {
+        {"Merge", merge_dot_product},
+        {"FMA", fma_dot_product},
+        {"Kobbelt", kobbelt_dot_product},
+        {"Long Acc", long_accumulator_dot_product},
+        {"Pichat", pichat_dot_product},
+        {"Sorting", sorting_dot_product},
+        {"Auto", auto_dot_product},
+        {"Binned", binned_dot_product},
+        {"Narrow", narrow_dot_product},
+        {"DotK 3", dotk_dot_product<3>},
+        {"DotK 4", dotk_dot_product<4>},
+        {"DotK 8", dotk_dot_product<8>},
+        {"Merge MT", merge_mt},
+        {"Kobbelt MT", kobbelt_mt},
+        {"Long MT", long_mt},
+        {"Binned MT", binned_mt},
+    };
+
+    printf("{\n  \"simd\": \"%s\",\n  \"threads\": %zu,\n  \"cycles\": \"%s\",\n  \"results\": [",
+           simd_level_name(detect_simd_level()), default_thread_count(),
+#ifdef BENCH_HAVE_TSC
+           "tsc"
+#else
+           "none"
+#endif
+           );
+    bool first = true;
+    for (const Distribution& dist : distributions){
+        for (size_t n = 10; n <= max_size; n *= 10){
+            mt19937_64 rng(20250423);
+            Input in = dist.make(n, rng);
+            DotView a(in.a), b(in.b);
+            const double exact = long_accumulator_dot_product(a, b);
+
+            for (const Algorithm& algo : algorithms){
+                fprintf(stderr, "%s n=%zu %s\n", dist.name, n, algo.name);
+                double result = 0.0;
+                Timing t = measure(min_time, [&]{ result = algo.run(a, b); });
+
+                double ulps;
+                bool has_error = ulp_error(result, exact, ulps);
+                printf("%s\n    {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"n\": %zu, "
+                       "\"ns_per_element\": %.4g, \"gb_per_s\": %.4g, \"cycles_per_element\": %.4g, "
+                       "\"repetitions\": %zu, \"ulp_error\": ",
+                       first ? "" : ",", algo.name, dist.name, n,
+                       t.seconds * 1e9 / n, 2.0 * sizeof(double) * n / t.seconds * 1e-9,
+                       (double)t.cycles / n, t.repetitions);
+                if (has_error) printf("%.4g}", ulps);
+                else printf("null}");
+                first = false;
+                fflush(stdout);
+            }
+        }
+    }
+    printf("\n  ]");
+    bench_gemv(min_time);
+    printf("\n}\n");
+    return 0;
+}
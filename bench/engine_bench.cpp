@@ -0,0 +1,198 @@
+#include "adaptive.hpp"
+#include "cpu_dispatch.hpp"
+#include "engine.hpp"
+#include "fma.hpp"
+#include "kobbelt.hpp"
+#include "merge.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Нагрузочный тест движка: P отправителей одновременно шлют заявки
+// смешанной длины (80 % — 8..256, 18 % — до 16384, 2 % — разделяемые
+// длинные) и держат не больше --window заявок в полёте. Для сравнения тот
+// же поток заявок считается блокирующими вызовами в потоках отправителей.
+// Задержка — от отправки до результата; печатаются p50, p99, максимум и
+// пропускная способность. Результат — JSON в stdout.
+//
+//   dot_product_engine_bench [--max-producers P] [--threads T] [--requests N] [--window W]
+
+using Clock = chrono::steady_clock;
+
+struct Job {
+    size_t offset;
+    size_t n;
+};
+
+struct Run {
+    vector<double> latency_us;
+    double seconds;
+    DotEngineStats stats;
+};
+
+static const size_t POOL_SIZE = 4 * ENGINE_SPLIT + 4096;
+
+static vector<Job> make_jobs(size_t count, mt19937_64& rng){
+    vector<Job> jobs(count);
+    for (Job& job : jobs){
+        size_t kind = rng() % 100;
+        double lo, hi;
+        if (kind < 80){ lo = 8; hi = ENGINE_SMALL; }
+        else if (kind < 98){ lo = ENGINE_SMALL; hi = 16384; }
+        else { lo = ENGINE_SPLIT; hi = 4 * ENGINE_SPLIT; }
+        // Длина лог-равномерна в [lo, hi]
+        double u = (double)(rng() >> 11) * 0x1p-53;
+        job.n = (size_t)(lo * pow(hi / lo, u));
+        job.offset = rng() % (POOL_SIZE - job.n + 1);
+    }
+    return jobs;
+}
+
+static double run_blocking_call(DotAlgorithm algorithm, DotView a, DotView b){
+    switch (algorithm){
+        case DotAlgorithm::Fma:     return fma_dot_product(a, b);
+        case DotAlgorithm::Merge:   return merge_dot_product(a, b);
+        case DotAlgorithm::Kobbelt: return kobbelt_dot_product(a, b);
+        default:                    return auto_dot_product(a, b);
+    }
+}
+
+static Run run_blocking(const vector<vector<Job>>& jobs, const vector<double>& a, const vector<double>& b,
+                        DotAlgorithm algorithm){
+    Run run;
+    vector<vector<double>> latency(jobs.size());
+    auto start = Clock::now();
+    vector<thread> threads;
+    for (size_t p = 0; p < jobs.size(); p++){
+        threads.emplace_back([&, p]{
+            volatile double sink = 0.0;
+            for (const Job& job : jobs[p]){
+                auto t0 = Clock::now();
+                sink = run_blocking_call(algorithm, DotView(a.data() + job.offset, job.n),
+                                         DotView(b.data() + job.offset, job.n));
+                latency[p].push_back(chrono::duration<double, micro>(Clock::now() - t0).count());
+            }
+            (void)sink;
+        });
+    }
+    for (auto& th : threads) th.join();
+    run.seconds = chrono::duration<double>(Clock::now() - start).count();
+    for (auto& l : latency) run.latency_us.insert(run.latency_us.end(), l.begin(), l.end());
+    run.stats = DotEngineStats{};
+    return run;
+}
+
+static Run run_engine(const vector<vector<Job>>& jobs, const vector<double>& a, const vector<double>& b,
+                      DotAlgorithm algorithm, size_t engine_threads, size_t window){
+    Run run;
+    vector<vector<double>> latency(jobs.size());
+    for (size_t p = 0; p < jobs.size(); p++) latency[p].resize(jobs[p].size());
+    DotEngine engine(engine_threads);
+    auto start = Clock::now();
+    vector<thread> threads;
+    for (size_t p = 0; p < jobs.size(); p++){
+        threads.emplace_back([&, p]{
+            atomic<size_t> in_flight{0};
+            for (size_t k = 0; k < jobs[p].size(); k++){
+                while (in_flight.load() >= window) this_thread::yield();
+                in_flight++;
+                const Job& job = jobs[p][k];
+                auto t0 = Clock::now();
+                double* slot = &latency[p][k];
+                engine.submit(DotView(a.data() + job.offset, job.n), DotView(b.data() + job.offset, job.n), algorithm,
+                              [slot, t0, &in_flight](double){
+                                  *slot = chrono::duration<double, micro>(Clock::now() - t0).count();
+                                  in_flight--;
+                              });
+            }
+            while (in_flight.load() != 0) this_thread::yield();
+        });
+    }
+    for (auto& th : threads) th.join();
+    run.seconds = chrono::duration<double>(Clock::now() - start).count();
+    run.stats = engine.stats();
+    for (auto& l : latency) run.latency_us.insert(run.latency_us.end(), l.begin(), l.end());
+    return run;
+}
+
+static double percentile(vector<double>& sorted, double q){
+    if (sorted.empty()) return 0.0;
+    size_t k = min(sorted.size() - 1, (size_t)(q * (sorted.size() - 1) + 0.5));
+    return sorted[k];
+}
+
+int main(int argc, char** argv){
+    size_t max_producers = 16;
+    size_t engine_threads = 0;
+    size_t total_requests = 20000;
+    size_t window = 64;
+    for (int i = 1; i < argc; i++){
+        if (!strcmp(argv[i], "--max-producers") && i + 1 < argc) max_producers = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) engine_threads = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--requests") && i + 1 < argc) total_requests = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--window") && i + 1 < argc) window = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        else {
+            fprintf(stderr, "usage: %s [--max-producers P] [--threads T] [--requests N] [--window W]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    mt19937_64 rng(20250423);
+    vector<double> a(POOL_SIZE), b(POOL_SIZE);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t i = 0; i < POOL_SIZE; i++){
+        a[i] = dist(rng);
+        b[i] = dist(rng);
+    }
+
+    struct Named { const char* name; DotAlgorithm algorithm; };
+    const Named algorithms[] = {
+        {"FMA", DotAlgorithm::Fma},
+        {"Merge", DotAlgorithm::Merge},
+        {"Kobbelt", DotAlgorithm::Kobbelt},
+        {"Exact", DotAlgorithm::Exact},
+    };
+
+    printf("{\n  \"simd\": \"%s\",\n  \"threads\": %zu,\n  \"window\": %zu,\n  \"results\": [",
+           simd_level_name(detect_simd_level()), engine_threads ? engine_threads : default_thread_count(), window);
+    bool first = true;
+    for (size_t producers = 1; producers <= max_producers; producers *= 2){
+        vector<vector<Job>> jobs(producers);
+        for (size_t p = 0; p < producers; p++) jobs[p] = make_jobs(total_requests / producers, rng);
+        size_t elements = 0;
+        for (auto& list : jobs) for (const Job& job : list) elements += job.n;
+
+        for (const Named& algo : algorithms){
+            for (int mode = 0; mode < 2; mode++){
+                const char* mode_name = mode == 0 ? "blocking" : "engine";
+                fprintf(stderr, "%s producers=%zu %s\n", algo.name, producers, mode_name);
+                Run run = mode == 0 ? run_blocking(jobs, a, b, algo.algorithm)
+                                    : run_engine(jobs, a, b, algo.algorithm, engine_threads, window);
+                sort(run.latency_us.begin(), run.latency_us.end());
+                printf("%s\n    {\"mode\": \"%s\", \"algorithm\": \"%s\", \"producers\": %zu, \"requests\": %zu, "
+                       "\"p50_us\": %.4g, \"p99_us\": %.4g, \"max_us\": %.4g, "
+                       "\"requests_per_s\": %.4g, \"gelements_per_s\": %.4g, "
+                       "\"coalesced\": %llu, \"split\": %llu, \"stolen\": %llu}",
+                       first ? "" : ",", mode_name, algo.name, producers, run.latency_us.size(),
+                       percentile(run.latency_us, 0.5), percentile(run.latency_us, 0.99),
+                       run.latency_us.empty() ? 0.0 : run.latency_us.back(),
+                       run.latency_us.size() / run.seconds, elements / run.seconds * 1e-9,
+                       (unsigned long long)run.stats.coalesced, (unsigned long long)run.stats.split,
+                       (unsigned long long)run.stats.stolen);
+                first = false;
+                fflush(stdout);
+            }
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
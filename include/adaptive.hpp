@@ -0,0 +1,34 @@
+#pragma once
+#include "dot_view.hpp"
+#include <vector>
+
+using namespace std;
+
+// Что сделал auto_dot_product
+struct AutoDotInfo {
+    bool certified;         // хватило быстрого прохода, точный не запускался
+    double error_bound;     // граница |Merge - точное значение| до округления
+    double condition;       // оценка числа обусловленности sum|a_i·b_i| / |результат|
+};
+
+// Корректно округлённое скалярное произведение с адаптивной стоимостью.
+// Сначала — проход Merge (Dot2 в 16 цепочках) со строгой границей
+// погрешности. Если граница гарантирует, что точное значение округляется
+// в то же число, результат возвращается сразу; иначе считается точно
+// (narrow_dot_product: разряды для узкого диапазона экспонент, иначе
+// длинный аккумулятор). Результат в обоих случаях побитово совпадает с точными
+// алгоритмами, на хорошо обусловленных данных стоимость — как у Merge.
+double auto_dot_product(const vector<double>& a, const vector<double>& b);
+double auto_dot_product(DotView a, DotView b);
+
+// То же, с отчётом: сработала ли быстрая проверка, граница и обусловленность
+double auto_dot_product(DotView a, DotView b, AutoDotInfo& info);
+
+// Строгая граница |hi + lo - sum a_i·b_i| для компенсированных цепочек
+// Dot2 по n элементам (одна цепочка или 16 цепочек Merge). abs_sum —
+// sum |fl(a_i·b_i)|, посчитанная в тех же цепочках.
+double dot2_error_bound(size_t n, double abs_sum);
+
+// true и корректно округлённое значение в result, если граница bound
+// гарантирует, что точное значение округляется так же, как hi + lo
+bool certified_round(double hi, double lo, double bound, double& result);
@@ -0,0 +1,47 @@
+#pragma once
+#include "eft.hpp"
+#include "fma.hpp"
+#include "merge.hpp"
+#include <cmath>
+#include <cstddef>
+
+using namespace std;
+
+// Одно короткое скалярное произведение из пакета
+struct DotPair {
+    const double* a;
+    const double* b;
+};
+
+// Пакетные варианты: out[k] — результат для pairs[k], у всех пар длина n.
+// Результаты побитово совпадают с fma_dot_product / merge_dot_product.
+// Пары обрабатываются по четыре в регистрах AVX2 (элемент i четырёх пар —
+// один вектор); для n = 8, 16, 32, 64 ядра собраны с длиной, известной
+// при компиляции, и циклы по элементам полностью развёрнуты.
+void fma_dot_product_batch(const DotPair* pairs, size_t count, size_t n, double* out);
+void merge_dot_product_batch(const DotPair* pairs, size_t count, size_t n, double* out);
+
+// Одиночный вызов с длиной N, известной при компиляции: без косвенности
+// vector и цикла с проверкой размера, встраивается в код вызывающего
+template<size_t N>
+inline double fma_dot_product_fixed(const double* a, const double* b){
+    double fma_sum = 0.0;
+#pragma GCC unroll 64
+    for (size_t i = 0; i < N; i++){
+        fma_sum = fma(a[i], b[i], fma_sum);
+    }
+    return fma_sum;
+}
+
+template<size_t N>
+inline double merge_dot_product_fixed(const double* a, const double* b){
+    double hi[MERGE_LANES] = {};
+    double lo[MERGE_LANES] = {};
+#pragma GCC unroll 64
+    for (size_t i = 0; i < N; i++){
+        dot2_update(hi[i % MERGE_LANES], lo[i % MERGE_LANES], a[i], b[i]);
+    }
+    double result = dod_get(merge_lanes_result(hi, lo));
+    if (!isfinite(result)) return merge_dot_product(DotView(a, N), DotView(b, N));
+    return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "dot_view.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Воспроизводимое суммирование с предварительным округлением (binned, как
+// в ReproBLAS). Ось двоичных разрядов разбита на корзины по BIN_BITS бит с
+// фиксированными границами. Окно — BINS корзин, старшая выбирается по
+// наибольшему ключу e_a + e_b среди ненулевых произведений (один просмотр
+// блока), так что |a_i·b_i| < 2^(β_top + BIN_BITS) для всех i.
+//
+// Обе части TwoProd каждого произведения раскладываются на корзины окна
+// общими ядрами digit_split.hpp: q = (v + σ_j) - σ_j в double, по SIMD-
+// разрядам. Остаток ниже окна отбрасывается. Суммы корзин блока точны и
+// переносятся в целые суммы корзин. Сумма корзин слагаемого от j и выше —
+// его округление до кратного 2^β_j, поэтому при подъёме окна младшие
+// корзины просто отбрасываются.
+//
+// Окно зависит только от максимума ключей, а вклад слагаемого — только от
+// самого числа и окна. Поэтому результат побитово одинаков при любой
+// перестановке, разбиении на блоки и числе потоков. Погрешность до
+// финального округления — меньше n · 2^-79 · max|a_i·b_i| (для субнормальных
+// множителей вместо |x| берётся 2^-1023).
+class BinnedAccumulator {
+public:
+    static const int BINS = 3;
+    static const int BIN_BITS = 40;
+
+    void add(DotView a, DotView b);
+    void add_product(double a, double b);
+    void merge(const BinnedAccumulator& other);
+    double finalize() const;
+
+    static constexpr size_t SERIALIZED_SIZE = 4 + 1 + 1 + 4 + BINS * 16;
+    vector<uint8_t> serialize() const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    static constexpr int MIN_EXP = -2148;       // граница корзины 0; β_j = MIN_EXP + BIN_BITS·j
+
+    void add_block(const double* a, const double* b, size_t n);
+    void shift_window(int new_top);
+
+    int top = -1;                               // номер старшей корзины окна; -1 — пусто
+    __int128 bins[BINS] = {};                   // bins[k] — сумма корзины top - k в единицах 2^β
+    bool has_nan = false;
+    bool has_pos_inf = false;
+    bool has_neg_inf = false;
+};
+
+double binned_dot_product(const vector<double>& a, const vector<double>& b);
+double binned_dot_product(DotView a, DotView b);
+
+// Параллельный вариант: аккумуляторы потоков сливаются, результат
+// совпадает с последовательным при любом числе потоков
+double binned_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads = 0);
+double binned_dot_product_parallel(DotView a, DotView b, size_t threads = 0);
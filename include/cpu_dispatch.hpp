@@ -0,0 +1,16 @@
+#pragma once
+
+// Уровни SIMD для выбора ядра во время выполнения
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,       // AVX2 + FMA
+    AVX512      // AVX-512F
+};
+
+// Лучший уровень, поддерживаемый процессором. Определяется один раз;
+// переменная окружения DOT_PRODUCT_SIMD=scalar|sse2|avx2|avx512 может
+// только понизить уровень (для проверки всех ядер на одной машине).
+SimdLevel detect_simd_level();
+
+const char* simd_level_name(SimdLevel level);
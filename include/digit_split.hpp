@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Общие ядра разложения произведений на разряды с фиксированными границами
+// (narrow_dot_product, BinnedAccumulator).
+//
+// Разряд j — кратные 2^β_j. Выделение по Руму: q = (v + σ_j) - σ_j при
+// σ_j = 1.5·2^(β_j+52) — это v, округлённое к ближайшему (к чётному)
+// кратному 2^β_j, а v - q точно. Обе части TwoProd раскладываются сверху
+// вниз по разрядам D-1 … 1, остаток идёт в разряд 0 (σ_0 не используется).
+// Сумма разрядов с j и выше у каждого слагаемого — его округление до
+// кратного 2^β_j, от старших разрядов она не зависит.
+//
+// Суммы точны, пока слагаемое каждого разряда j >= 1 по модулю не больше
+// 2^(β_j+41) и на разряд приходится не больше 2·SPLIT_BLOCK слагаемых:
+// тогда сумма меньше 2^(β_j+52). При этом порядок слагаемых, число цепочек
+// и уровень SIMD на результат не влияют.
+
+const size_t SPLIT_BLOCK = 1024;
+const int SPLIT_MAX_DIGITS = 6;
+
+// Ключи e_a + e_b ненулевых произведений и смещённые экспоненты самих
+// чисел: максимальная экспонента 2047 — Inf или NaN, минимальная среди
+// ненулевых 0 — субнормаль
+struct KeyRange {
+    int64_t min_key = 1 << 20;
+    int64_t max_key = 0;
+    int64_t min_exp = 1 << 20;
+    int64_t max_exp = 0;
+
+    void merge(const KeyRange& other){
+        min_key = min(min_key, other.min_key);
+        max_key = max(max_key, other.max_key);
+        min_exp = min(min_exp, other.min_exp);
+        max_exp = max(max_exp, other.max_exp);
+    }
+};
+
+// Диапазон ключей и экспонент n элементов, добавляется к range
+void scan_keys(const double* a, const double* b, size_t n, KeyRange& range);
+
+// Прибавляет к d[0..digits) разряды всех a_i·b_i, i < n <= SPLIT_BLOCK;
+// digits от 3 до SPLIT_MAX_DIGITS
+void split_digits(const double* a, const double* b, size_t n, int digits, const double* sigma, double* d);
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// Общие части точных аккумуляторов (LongAccumulator, BinnedAccumulator) и
+// двоичных форматов: разбор double на целую мантиссу, округление длинного
+// целого в 32-битных разрядах, поля little-endian.
+
+// Разбор double: x = ±mant·2^exp; special — Inf или NaN
+struct Decomposed {
+    uint64_t mant;
+    int exp;
+    bool negative;
+    bool special;
+};
+
+inline Decomposed decompose(double x){
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    Decomposed d;
+    int biased = (int)((bits >> 52) & 0x7FF);
+    uint64_t frac = bits & ((1ULL << 52) - 1);
+    d.negative = (bits >> 63) != 0;
+    d.special = biased == 0x7FF;
+    if (biased == 0){
+        d.mant = frac;                          // субнормаль
+        d.exp = -1074;
+    } else {
+        d.mant = frac | (1ULL << 52);
+        d.exp = biased - 1075;
+    }
+    return d;
+}
+
+// Длинное целое Σ d[i]·2^(32·i) в разрядах int64 с отложенными переносами
+const int EXACT_DIGIT_BITS = 32;
+
+// Распространение переносов: младшие разряды в [0, 2^32), старший знаковый
+inline void normalize_digits(int64_t* d, int count){
+    for (int i = 0; i < count - 1; i++){
+        int64_t carry = d[i] >> EXACT_DIGIT_BITS;
+        d[i] -= carry * (1LL << EXACT_DIGIT_BITS);
+        d[i + 1] += carry;
+    }
+}
+
+// Корректное округление к ближайшему (к чётному при равенстве) значения
+// Σ d[i]·2^(32·i + weight)·2^scale. Разряды могут быть ненормализованы;
+// массив используется как рабочий и портится.
+double round_digits(int64_t* d, int count, int weight, int scale = 0);
+
+inline void put_le(uint8_t* out, uint64_t value, int bytes){
+    for (int k = 0; k < bytes; k++) out[k] = (uint8_t)(value >> (8 * k));
+}
+
+inline void put_le(vector<uint8_t>& out, uint64_t value, int bytes){
+    for (int k = 0; k < bytes; k++) out.push_back((uint8_t)(value >> (8 * k)));
+}
+
+inline uint64_t get_le(const uint8_t* data, int bytes){
+    uint64_t value = 0;
+    for (int k = bytes - 1; k >= 0; k--) value = (value << 8) | data[k];
+    return value;
+}
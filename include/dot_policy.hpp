@@ -0,0 +1,121 @@
+#pragma once
+#include "eft.hpp"
+#include "kobbelt.hpp"
+#include "long_accumulator.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Заголовочная библиотека ядер: преобразование произведения, аккумулятор
+// и тип элементов выбираются при компиляции, каждая комбинация
+// встраивается целиком — в том числе в собственные циклы вызывающего:
+//
+//   DotKernel<TwoProdProduct, DoubleDoubleSum> k;
+//   for (...) k.add(x[i] * scale, y[i]);
+//   double r = k.result();
+//
+// Код, встраивающий эти ядра, нужно собирать с -ffp-contract=off.
+
+// ── Аккумуляторы ───────────────────────────────────────────────────────────
+// add(x)          — прибавить слагаемое;
+// add_error(e)    — прибавить поправку (ошибку произведения);
+// add_fused(a, b) — прибавить a·b без отдельного округления произведения;
+// result()        — округлённая сумма.
+
+// Обычная сумма в double
+struct NaiveSum {
+    double sum = 0.0;
+
+    void add(double x){ sum += x; }
+    void add_error(double e){ sum += e; }
+    void add_fused(double a, double b){ sum = fma(a, b, sum); }
+    double result() const { return sum; }
+};
+
+// Сумма double-double: старшая часть через TwoSum, ошибки копятся в lo
+struct DoubleDoubleSum {
+    double hi = 0.0;
+    double lo = 0.0;
+
+    void add(double x){
+        pair<double, double> s = two_sum(hi, x);
+        hi = s.first;
+        lo += s.second;
+    }
+    void add_error(double e){ lo += e; }
+    void add_fused(double a, double b){ dot2_update(hi, lo, a, b); }
+    double result() const { return dod_get(DoubleDouble{hi, lo}); }
+};
+
+// Таблица корзин по экспоненте (KobbeltAccumulator) — точная сумма
+struct BucketedSum {
+    KobbeltAccumulator table;
+
+    void add(double x){ table.add(x); }
+    void add_error(double e){ table.add(e); }
+    void add_fused(double a, double b){ table.add_product(a, b); }
+    double result() const { return table.finalize(); }
+};
+
+// Длинный аккумулятор Кулиша — точная сумма
+struct SuperAccumulatorSum {
+    LongAccumulator acc;
+
+    void add(double x){ acc.add(x); }
+    void add_error(double e){ acc.add(e); }
+    void add_fused(double a, double b){ acc.add_product(a, b); }
+    double result() const { return acc.round(); }
+};
+
+// ── Преобразования произведения ─────────────────────────────────────────────
+
+// Округлённое произведение
+struct PlainProduct {
+    template<class Accumulator>
+    static void feed(Accumulator& acc, double a, double b){ acc.add(a * b); }
+};
+
+// Произведение сливается с накоплением: для NaiveSum — одна инструкция FMA,
+// для остальных аккумуляторов — точное произведение
+struct FmaProduct {
+    template<class Accumulator>
+    static void feed(Accumulator& acc, double a, double b){ acc.add_fused(a, b); }
+};
+
+// TwoProd: округлённое произведение и его ошибка. Ошибка точна, пока
+// произведение не переполняется и не уходит в субнормали; точным
+// аккумуляторам для полного диапазона нужен FmaProduct
+struct TwoProdProduct {
+    template<class Accumulator>
+    static void feed(Accumulator& acc, double a, double b){
+        pair<double, double> p = exact_multiply(a, b);
+        acc.add(p.first);
+        acc.add_error(p.second);
+    }
+};
+
+// ── Ядро ────────────────────────────────────────────────────────────────────
+
+// Элементы типа T (double, float) переводятся в double без потерь;
+// произведение двух float в double точно.
+template<class Product, class Accumulator, class T = double>
+struct DotKernel {
+    Accumulator acc;
+
+    void add(T a, T b){ Product::feed(acc, (double)a, (double)b); }
+    double result() const { return acc.result(); }
+};
+
+template<class Product, class Accumulator, class T = double>
+inline double policy_dot_product(const T* a, const T* b, size_t n){
+    DotKernel<Product, Accumulator, T> kernel;
+    for (size_t i = 0; i < n; i++) kernel.add(a[i], b[i]);
+    return kernel.result();
+}
+
+template<class Product, class Accumulator, class T = double>
+inline double policy_dot_product(const vector<T>& a, const vector<T>& b){
+    return policy_dot_product<Product, Accumulator, T>(a.data(), b.data(), a.size());
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Невладеющее представление операнда: size элементов data[0], data[stride],
+// data[2*stride], ... Подходит для столбцов матриц, строк с шагом и
+// отображённых в память буферов без копирования в vector.
+struct DotView {
+    const double* data;
+    size_t size;
+    ptrdiff_t stride;
+
+    DotView(const double* data, size_t size, ptrdiff_t stride = 1)
+        : data(data), size(size), stride(stride) {}
+    DotView(const vector<double>& v) : data(v.data()), size(v.size()), stride(1) {}
+
+    double operator[](size_t i) const { return data[(ptrdiff_t)i * stride]; }
+    bool contiguous() const { return stride == 1; }
+    DotView slice(size_t begin, size_t count) const {
+        return DotView(data + (ptrdiff_t)begin * stride, count, stride);
+    }
+};
+
+// Рабочая память для алгоритмов, которым нужен буфер произведений (Pichat,
+// Sorting). Буфер только растёт, поэтому повторные вызовы с одним
+// workspace не выделяют память.
+class DotWorkspace {
+public:
+    void reserve(size_t n){ if (storage.size() < n) storage.resize(n); }
+    double* buffer(size_t n){ reserve(n); return storage.data(); }
+
+private:
+    vector<double> storage;
+};
+
+// Workspace текущего потока — используется, когда вызывающий свой не передал
+DotWorkspace& thread_workspace();
@@ -0,0 +1,37 @@
+#pragma once
+#include "dot_view.hpp"
+#include <vector>
+
+using namespace std;
+
+// K-кратно компенсированное скалярное произведение DotK (Ogita, Rump,
+// Oishi). Результат такой, как если бы сумма считалась с K-кратной
+// точностью и затем округлялась к double:
+//   |res - a·b| <= (u + 2γ²)|a·b| + γ^K · sum |a_i·b_i|,  γ = γ_{4n-2}.
+// K = 2 — это Dot2 (как Merge), каждый следующий уровень добавляет около
+// 53 бит, поэтому можно платить ровно за нужную обусловленность, не
+// переходя сразу к точным методам.
+//
+// Вариант «вертикальный»: вместо массива из 2n слагаемых каждая цепочка
+// держит K уровней s_0 … s_{K-1}. Произведение входит в s_0, ошибка
+// каждого TwoSum спускается на уровень ниже, ошибка TwoProd входит с
+// уровня 1, последний уровень копится обычным сложением. При K = 2 это в
+// точности dot2_update из eft.hpp.
+//
+// Элемент i попадает в цепочку i % DOTK_LANES. Число цепочек одинаково на
+// всех уровнях SIMD, цепочки сливаются в фиксированном порядке, поэтому
+// результат побитово не зависит от процессора.
+
+const int DOTK_MIN = 2;
+const int DOTK_MAX = 8;
+const size_t DOTK_LANES = 16;
+
+// K выбирается при компиляции: ядро развёрнуто по уровням.
+// Определена для K от DOTK_MIN до DOTK_MAX.
+template<int K>
+double dotk_dot_product(DotView a, DotView b);
+
+// K во время выполнения — выбор одного из тех же ядер. K вне
+// [DOTK_MIN, DOTK_MAX] прижимается к ближайшей границе.
+double dotk_dot_product(DotView a, DotView b, int k);
+double dotk_dot_product(const vector<double>& a, const vector<double>& b, int k);
@@ -0,0 +1,54 @@
+#pragma once
+#include <cmath>
+#include <utility>
+
+using namespace std;
+
+// Безошибочные преобразования (TwoSum, TwoProd) и double-double сумма —
+// общие строительные блоки компенсированных алгоритмов. Код, который их
+// встраивает, нужно собирать с -ffp-contract=off: иначе компилятор может
+// слить a*b+c в FMA и ошибка перестанет быть точной.
+
+struct DoubleDouble{
+    double hi; // Основная часть
+    double lo; // Корректирующая часть
+};
+
+// Точное сложение (TwoSum): a + b = s + err
+inline pair<double, double> two_sum(double a, double b){
+    double s = a + b;
+    double z = s - a;
+    double err = (a - (s - z)) + (b - z);
+    return {s, err};
+}
+
+// Точное умножение с использованием FMA
+inline pair<double, double> exact_multiply(double a, double b){
+    double prod = a * b;
+    double err = fma(a, b, -prod); // Вычисление ошибки
+    return {prod, err};
+}
+
+inline void dod_add(DoubleDouble& sum, double x, double err){
+    pair<double, double> s1 = two_sum(sum.hi, x);
+    pair<double, double> s2 = two_sum(s1.first, s1.second + err + sum.lo);
+
+    sum.hi = s2.first;
+    sum.lo = s2.second;
+}
+
+inline double dod_get(const DoubleDouble& sum){
+    double result = sum.hi + sum.lo;
+    double residual = (sum.hi - result) + sum.lo;
+    return result + residual;
+}
+
+// Шаг компенсированной цепочки (Dot2): hi += a*b через TwoSum, ошибки
+// сложения и умножения копятся в lo. Векторные ядра повторяют ровно эту
+// последовательность операций.
+inline void dot2_update(double& hi, double& lo, double a, double b){
+    pair<double, double> prod = exact_multiply(a, b);
+    pair<double, double> sum = two_sum(hi, prod.first);
+    hi = sum.first;
+    lo += sum.second + prod.second;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "eft.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Векторные two_sum и dot2_update из eft.hpp для ядер AVX2 и AVX-512. В
+// каждом разряде — ровно та же последовательность операций, что в скалярном
+// коде: на этом держится побитовое совпадение результатов на всех уровнях
+// SIMD. Функции собраны с target и встраиваются только в ядра того же
+// уровня.
+
+// TwoSum по разрядам: s += x, возвращается ошибка
+__attribute__((target("avx2,fma")))
+inline __m256d two_sum_avx2(__m256d& s, __m256d x){
+    __m256d sum = _mm256_add_pd(s, x);
+    __m256d z = _mm256_sub_pd(sum, s);
+    __m256d err = _mm256_add_pd(_mm256_sub_pd(s, _mm256_sub_pd(sum, z)), _mm256_sub_pd(x, z));
+    s = sum;
+    return err;
+}
+
+// TwoProd по разрядам (exact_multiply): x·y = p + err, возвращается p
+__attribute__((target("avx2,fma")))
+inline __m256d two_prod_avx2(__m256d x, __m256d y, __m256d& err){
+    __m256d p = _mm256_mul_pd(x, y);
+    err = _mm256_fmsub_pd(x, y, p);
+    return p;
+}
+
+// Шаг Dot2 (dot2_update) по разрядам; возвращается произведение fl(x·y)
+__attribute__((target("avx2,fma")))
+inline __m256d dot2_step_avx2(__m256d& h, __m256d& l, __m256d x, __m256d y){
+    __m256d e;
+    __m256d p = two_prod_avx2(x, y, e);
+    __m256d t = two_sum_avx2(h, p);
+    l = _mm256_add_pd(l, _mm256_add_pd(t, e));
+    return p;
+}
+
+__attribute__((target("avx512f")))
+inline __m512d two_sum_avx512(__m512d& s, __m512d x){
+    __m512d sum = _mm512_add_pd(s, x);
+    __m512d z = _mm512_sub_pd(sum, s);
+    __m512d err = _mm512_add_pd(_mm512_sub_pd(s, _mm512_sub_pd(sum, z)), _mm512_sub_pd(x, z));
+    s = sum;
+    return err;
+}
+
+__attribute__((target("avx512f")))
+inline __m512d two_prod_avx512(__m512d x, __m512d y, __m512d& err){
+    __m512d p = _mm512_mul_pd(x, y);
+    err = _mm512_fmsub_pd(x, y, p);
+    return p;
+}
+
+__attribute__((target("avx512f")))
+inline __m512d dot2_step_avx512(__m512d& h, __m512d& l, __m512d x, __m512d y){
+    __m512d e;
+    __m512d p = two_prod_avx512(x, y, e);
+    __m512d t = two_sum_avx512(h, p);
+    l = _mm512_add_pd(l, _mm512_add_pd(t, e));
+    return p;
+}
+#endif
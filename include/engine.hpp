@@ -0,0 +1,72 @@
+#pragma once
+#include "dot_view.hpp"
+#include "parallel.hpp"
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+
+using namespace std;
+
+// Асинхронный движок скалярных произведений для сервиса с множеством
+// одновременных запросов разной длины. Заявка (a, b, алгоритм) кладётся в
+// неблокирующую очередь (кольцо MPMC с номерами поколений в ячейках);
+// результат приходит через future или callback.
+//
+// Рабочие потоки забирают заявки из очереди. Короткие (не длиннее
+// ENGINE_SMALL) забираются пачкой до ENGINE_COALESCE штук; пачка
+// группируется по алгоритму и длине, и группы FMA/Merge с непрерывными
+// операндами идут в пакетные ядра batch.hpp. Длинные (от ENGINE_SPLIT)
+// делятся на блоки PARALLEL_BLOCK. Блоки ложатся в деку взявшего потока,
+// а свободные потоки крадут их с другого конца; частичные результаты
+// блоков складываются точно.
+//
+// Результаты побитово совпадают с блокирующими вызовами: fma_dot_product,
+// merge_dot_product, kobbelt_dot_product, auto_dot_product (Exact). Для
+// разделённых заявок Merge совпадает с merge_dot_product_parallel, а FMA —
+// это точная сумма FMA-сумм блоков PARALLEL_BLOCK, округлённая один раз.
+// Разделённая заявка Exact, как auto_dot_product, сначала считается
+// блоками Merge с границей погрешности, точный проход по блокам нужен
+// только при плохой обусловленности. От числа потоков и нагрузки
+// результат не зависит.
+//
+// Операнды не копируются: данные a и b должны жить до получения
+// результата. Длины a и b должны совпадать.
+
+enum class DotAlgorithm { Fma, Merge, Kobbelt, Exact };
+
+const size_t ENGINE_QUEUE_SIZE = 4096;              // ёмкость очереди (степень двойки)
+const size_t ENGINE_SMALL = 256;                    // короткие заявки склеиваются в пачки
+const size_t ENGINE_COALESCE = 64;                  // заявок в одной пачке
+const size_t ENGINE_SPLIT = 2 * PARALLEL_BLOCK;     // длинные заявки делятся на блоки
+
+// Счётчики с момента создания движка
+struct DotEngineStats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t coalesced;         // заявок, посчитанных пакетными ядрами
+    uint64_t split;             // заявок, разделённых на блоки
+    uint64_t stolen;            // блоков, украденных другими потоками
+};
+
+class DotEngine {
+public:
+    // threads = 0 — по числу ядер
+    explicit DotEngine(size_t threads = 0);
+    // Дожидается всех принятых заявок
+    ~DotEngine();
+
+    DotEngine(const DotEngine&) = delete;
+    DotEngine& operator=(const DotEngine&) = delete;
+
+    future<double> submit(DotView a, DotView b, DotAlgorithm algorithm = DotAlgorithm::Merge);
+    // callback вызывается в рабочем потоке и не должен блокироваться надолго
+    void submit(DotView a, DotView b, DotAlgorithm algorithm, function<void(double)> callback);
+
+    size_t threads() const;
+    DotEngineStats stats() const;
+
+private:
+    struct Shared;
+    unique_ptr<Shared> shared;
+};
@@ -1,6 +1,8 @@
 #pragma once
+#include "dot_view.hpp"
 #include <vector>
 
 using namespace std;
 
-double fma_dot_product(const vector<double>& a, const vector<double>& b);
\ No newline at end of file
+double fma_dot_product(const vector<double>& a, const vector<double>& b);
+double fma_dot_product(DotView a, DotView b);
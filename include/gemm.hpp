@@ -0,0 +1,52 @@
+#pragma once
+#include "dot_view.hpp"
+#include <cstddef>
+
+using namespace std;
+
+// Невладеющее представление матрицы: элемент (i, j) лежит по адресу
+// data + i·row_stride + j·col_stride. Плотная матрица по строкам —
+// (rows, cols, cols, 1), по столбцам — (rows, cols, 1, rows).
+struct MatrixView {
+    const double* data;
+    size_t rows;
+    size_t cols;
+    ptrdiff_t row_stride;
+    ptrdiff_t col_stride;
+
+    MatrixView(const double* data, size_t rows, size_t cols)
+        : data(data), rows(rows), cols(cols), row_stride((ptrdiff_t)cols), col_stride(1) {}
+    MatrixView(const double* data, size_t rows, size_t cols, ptrdiff_t row_stride, ptrdiff_t col_stride)
+        : data(data), rows(rows), cols(cols), row_stride(row_stride), col_stride(col_stride) {}
+
+    double operator()(size_t i, size_t j) const {
+        return data[(ptrdiff_t)i * row_stride + (ptrdiff_t)j * col_stride];
+    }
+    DotView row(size_t i) const { return DotView(data + (ptrdiff_t)i * row_stride, cols, col_stride); }
+    DotView column(size_t j) const { return DotView(data + (ptrdiff_t)j * col_stride, rows, row_stride); }
+    MatrixView transposed() const { return MatrixView(data, cols, rows, col_stride, row_stride); }
+};
+
+enum class GemmMode {
+    // Каждый элемент — одна цепочка Dot2 (TwoProd + TwoSum) по k по
+    // возрастанию, результат hi + lo. Не зависит от блокировки, числа
+    // потоков и уровня SIMD. При переполнении промежуточных величин
+    // элемент может стать Inf или NaN, как у Merge без пересчёта.
+    Compensated,
+    // Корректно округлённый элемент: тот же проход с оценкой погрешности
+    // (как в auto_dot_product), неудостоверенные элементы пересчитываются
+    // длинным аккумулятором
+    Exact
+};
+
+// Инструментирование (instrument.hpp) не учитывает gemv и gemm целиком:
+// запись в отчёте — вызов с одним результатом. Элементы, пересчитанные
+// в режиме Exact, видны в отчёте как вызовы "Long Acc".
+
+// y = A·x, y — A.rows элементов с шагом y_stride; x.size == A.cols
+void gemv(MatrixView a, DotView x, double* y, ptrdiff_t y_stride = 1,
+          GemmMode mode = GemmMode::Compensated, size_t threads = 0);
+
+// C = A·B, C — A.rows × B.cols по строкам с шагом строк ldc; A.cols == B.rows
+void gemm(MatrixView a, MatrixView b, double* c, size_t ldc,
+          GemmMode mode = GemmMode::Compensated, size_t threads = 0);
@@ -0,0 +1,92 @@
+#pragma once
+#include "dot_view.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+using namespace std;
+
+// Инструментирование алгоритмов: время по фазам, гистограмма экспонент
+// произведений, степень сокращения, спецзначения и аппаратные счётчики
+// (perf_event_open). Включается опцией CMake DOT_PRODUCT_INSTRUMENTATION;
+// без неё макросы ниже пусты и код алгоритмов не меняется.
+//
+// Запись в отчёте — один вызов с одним результатом. Поэтому пакетные ядра
+// batch.hpp (out[k] на каждую пару) не учитываются: их вызывают внутренние
+// циклы, где проход статистики стоил бы дороже самого ядра.
+
+enum class DotPhase { Products, Accumulate, Finalize };
+const int DOT_PHASES = 3;
+
+// Накопленная статистика одного алгоритма по всем вызовам
+struct DotStats {
+    uint64_t calls = 0;
+    uint64_t elements = 0;
+    uint64_t phase_ns[DOT_PHASES] = {};
+    uint64_t exponent_histogram[2048] = {};     // смещённая экспонента fl(a_i·b_i)
+    uint64_t zeros = 0;
+    uint64_t subnormals = 0;
+    uint64_t infinities = 0;
+    uint64_t nans = 0;
+    double abs_sum = 0.0;                       // sum |a_i·b_i| по всем вызовам
+    double result_abs_sum = 0.0;                // sum |результат|
+    double max_cancellation = 0.0;              // max sum|a_i·b_i| / |результат| за вызов
+    // Аппаратные счётчики вызывающего потока; -1 — недоступны
+    int64_t cycles = -1;
+    int64_t instructions = -1;
+    int64_t cache_misses = -1;
+
+    void merge(const DotStats& other);
+};
+
+bool instrument_enabled();
+DotStats instrument_stats(const char* algorithm);
+void instrument_reset();
+void instrument_report(FILE* out);              // JSON по всем алгоритмам
+// Отчёт в файл из переменной окружения DOT_PRODUCT_STATS (по умолчанию —
+// в stderr); в сборке без инструментирования ничего не делает
+void instrument_export();
+
+#ifdef DOT_PRODUCT_INSTRUMENT
+// Один вызов алгоритма. Учитывается только внешний вызов: вложенные
+// (например, точный проход внутри auto_dot_product) не считаются отдельно.
+class InstrumentCall {
+public:
+    InstrumentCall(const char* algorithm, DotView a, DotView b);
+    // Вход не парой DotView (float, fp16, разреженные операнды):
+    // for_each_product(record) вызывает record(p) для каждого произведения
+    // в double, число вызовов — число элементов
+    template<class ForEachProduct>
+    InstrumentCall(const char* algorithm, ForEachProduct for_each_product) : InstrumentCall(algorithm){
+        if (!active) return;
+        for_each_product([this](double p){ record(p); });
+        start_counters();
+    }
+    ~InstrumentCall();
+
+    void phase(DotPhase next);                  // закрыть текущую фазу, начать next
+    double finish(double result);               // закрыть фазу и запомнить результат
+
+private:
+    explicit InstrumentCall(const char* algorithm);
+    void record(double product);
+    void start_counters();
+
+    const char* algorithm;
+    bool active;
+    bool finished = false;
+    int current = -1;
+    chrono::steady_clock::time_point phase_start;
+    DotStats stats;
+};
+
+#define DOT_INSTRUMENT_CALL(name, a, b) InstrumentCall dot_instrument_call(name, a, b)
+#define DOT_INSTRUMENT_CALL_PRODUCTS(name, for_each_product) InstrumentCall dot_instrument_call(name, for_each_product)
+#define DOT_INSTRUMENT_PHASE(phase_name) dot_instrument_call.phase(DotPhase::phase_name)
+#define DOT_INSTRUMENT_RESULT(result) dot_instrument_call.finish(result)
+#else
+#define DOT_INSTRUMENT_CALL(name, a, b) ((void)0)
+#define DOT_INSTRUMENT_CALL_PRODUCTS(name, for_each_product) ((void)0)
+#define DOT_INSTRUMENT_PHASE(phase_name) ((void)0)
+#define DOT_INSTRUMENT_RESULT(result) (result)
+#endif
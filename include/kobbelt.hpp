@@ -1,6 +1,108 @@
 #pragma once
+#include "dot_view.hpp"
+#include "long_accumulator.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 
 using namespace std;
 
-double kobbelt_dot_product(const vector<double>& a, const vector<double>& b);
\ No newline at end of file
+// Таблица Коббельта: корзина на каждую смещённую экспоненту. Число x из
+// корзины E раскладывается без ошибки на старшую часть q, кратную
+// 2^GRID_BITS ulp, и остаток r = x - q; q и r копятся в отдельных суммах
+// корзины. Обе суммы точны, пока в корзину добавлено меньше 2^GRID_BITS
+// чисел, поэтому раз в RENORMALIZE_INTERVAL добавлений таблица целиком
+// сбрасывается в длинный аккумулятор (перенормировка без ошибок).
+// Состояние фиксированного размера — подходит для потоковой обработки
+// порциями; формат serialize совпадает с LongAccumulator.
+class KobbeltAccumulator {
+public:
+    static const int SIZE = 2048;
+    static const int GRID_BITS = 26;
+
+    void add(DotView a, DotView b);
+    void add(double x);                         // += x (точно)
+    void add_product(double a, double b);       // += a*b (точно)
+    void merge(const KobbeltAccumulator& other);
+    double finalize() const;
+
+    vector<uint8_t> serialize() const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    static const uint32_t RENORMALIZE_INTERVAL = 1u << (GRID_BITS - 1);
+    // Ниже этого порога ошибка TwoProd может уйти в субнормали и потерять биты
+    static constexpr double TWO_PROD_SAFE_MIN = 0x1p-968;
+    // Выше этого порога константа расщепления или сумма корзины переполнится
+    static constexpr double SPLIT_SAFE_MAX = 0x1p996;
+
+    // sigma[E] = 1.5 · 2^52 · 2^GRID_BITS · ulp(E): (sigma + x) - sigma
+    // округляет x из корзины E до сетки 2^GRID_BITS ulp
+    struct SplitConstants {
+        double sigma[SIZE] = {};
+        SplitConstants(){
+            for (int e = 0; e < SIZE; e++){
+                int ulp_exp = (e > 1 ? e : 1) - 1075;   // субнормали — как E = 1
+                int exp = ulp_exp + GRID_BITS + 52;
+                if (exp < 1023) sigma[e] = ldexp(1.5, exp);
+            }
+        }
+    };
+    static const double* split_constants(){
+        static const SplitConstants constants;
+        return constants.sigma;
+    }
+
+    void insert(double x, const double* sigma);
+    void renormalize();
+
+    double high[SIZE] = {};
+    double low[SIZE] = {};
+    uint32_t pending = 0;
+    LongAccumulator spill;      // спецзначения, крайние экспоненты, сброс корзин
+};
+
+// Добавления определены в заголовке, чтобы встраиваться в циклы
+// вызывающего (в том числе в ядра dot_policy.hpp)
+inline void KobbeltAccumulator::insert(double x, const double* sigma){
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    uint32_t biased = (uint32_t)(bits >> 52) & 0x7FF;
+    double q = (sigma[biased] + x) - sigma[biased];
+    high[biased] += q;
+    low[biased] += x - q;
+}
+
+inline void KobbeltAccumulator::add(double x){
+    if (!(fabs(x) < SPLIT_SAFE_MAX)){
+        spill.add(x);               // Inf/NaN, крайние экспоненты
+        return;
+    }
+    insert(x, split_constants());
+    if (++pending >= RENORMALIZE_INTERVAL) renormalize();
+}
+
+inline void KobbeltAccumulator::add_product(double a, double b){
+    const double* sigma = split_constants();
+    double p = a * b;
+    double magnitude = fabs(p);
+    if (!(magnitude >= TWO_PROD_SAFE_MIN && magnitude < SPLIT_SAFE_MAX)){
+        spill.add_product(a, b);    // нули, Inf/NaN, крайние экспоненты
+        return;
+    }
+    insert(p, sigma);
+    insert(fma(a, b, -p), sigma);
+    if (++pending >= RENORMALIZE_INTERVAL) renormalize();
+}
+
+// Точное скалярное произведение с корректным округлением: произведения
+// раскладываются TwoProd и копятся в таблице KobbeltAccumulator, без
+// выделения памяти в куче.
+double kobbelt_dot_product(const vector<double>& a, const vector<double>& b);
+double kobbelt_dot_product(DotView a, DotView b);
+
+// Параллельный вариант: у каждого потока своя таблица, слияние точное,
+// поэтому результат совпадает с последовательным при любом числе потоков
+double kobbelt_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads = 0);
+double kobbelt_dot_product_parallel(DotView a, DotView b, size_t threads = 0);
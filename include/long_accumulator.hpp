@@ -1,6 +1,105 @@
 #pragma once
+#include "digits.hpp"
+#include "dot_view.hpp"
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 
 using namespace std;
 
-double long_accumulator_dot_product(const vector<double>& a, const vector<double>& b);
\ No newline at end of file
+// Длинный аккумулятор Кулиша: точная сумма в фиксированной точке,
+// покрывающей весь диапазон произведений double (2^-2148 .. 2^2048)
+// плюс 64 бита запаса под переполнение суммы.
+// Разряды по 32 бита хранятся в int64_t (carry-save), переносы
+// распространяются лениво — раз в NORMALIZE_INTERVAL добавлений.
+class LongAccumulator {
+public:
+    static constexpr int MIN_EXP = -2148;       // вес младшего бита
+    static constexpr int DIGIT_BITS = EXACT_DIGIT_BITS;
+    static constexpr int NUM_DIGITS = 134;      // 4288 бит
+
+    void add(double x);                         // += x (точно)
+    void add_product(double a, double b);       // += a*b (точно)
+    void add_scaled(unsigned __int128 m, int exp, bool negative); // += ±m·2^exp, exp >= MIN_EXP
+    void add(DotView a, DotView b);             // += a·b по очередной порции (точно)
+    void merge(const LongAccumulator& other);   // += other (точно)
+
+    // Корректное округление к ближайшему значения суммы, умноженной на
+    // 2^scale (масштаб точный: сумма, которая сама не помещается в double,
+    // округляется без переполнения и потери субнормалей)
+    double round(int scale = 0) const;
+    double finalize() const { return round(); }
+
+    // Состояние в переносимом виде (little-endian, SERIALIZED_SIZE байт):
+    // частичные суммы из разных процессов можно сохранить и слить позже.
+    // deserialize возвращает false и не меняет объект, если данные повреждены.
+    static constexpr size_t SERIALIZED_SIZE = 6 + 4 * (NUM_DIGITS - 1) + 8;
+    vector<uint8_t> serialize() const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    static constexpr uint32_t NORMALIZE_INTERVAL = 1u << 29;
+
+    void normalize();
+
+    int64_t digits[NUM_DIGITS] = {};
+    uint32_t pending = 0;                       // добавлений с последней нормализации
+    bool has_nan = false;
+    bool has_pos_inf = false;
+    bool has_neg_inf = false;
+};
+
+// Добавления определены в заголовке, чтобы встраиваться в циклы
+// вызывающего (в том числе в ядра dot_policy.hpp)
+inline void LongAccumulator::add_scaled(unsigned __int128 m, int exp, bool negative){
+    if (m == 0) return;
+    int pos = exp - MIN_EXP;
+    int index = pos / DIGIT_BITS;
+    int shift = pos % DIGIT_BITS;
+    int64_t sign = negative ? -1 : 1;
+    // Младшие и старшие 64 бита m, сдвинутые на shift, занимают по три
+    // 32-битных разряда; в каждый разряд попадает меньше 2^33 за вызов
+    unsigned __int128 lo = (unsigned __int128)(uint64_t)m << shift;
+    unsigned __int128 hi = (unsigned __int128)(uint64_t)(m >> 64) << shift;
+    digits[index]     += sign * (int64_t)(uint32_t)lo;
+    digits[index + 1] += sign * (int64_t)(uint32_t)(lo >> 32);
+    digits[index + 2] += sign * ((int64_t)(uint64_t)(lo >> 64) + (int64_t)(uint32_t)hi);
+    digits[index + 3] += sign * (int64_t)(uint32_t)(hi >> 32);
+    digits[index + 4] += sign * (int64_t)(uint64_t)(hi >> 64);
+    if (++pending >= NORMALIZE_INTERVAL) normalize();
+}
+
+inline void LongAccumulator::add(double x){
+    Decomposed d = decompose(x);
+    if (d.special){
+        if (d.mant != (1ULL << 52)) has_nan = true;
+        else if (d.negative) has_neg_inf = true;
+        else has_pos_inf = true;
+        return;
+    }
+    add_scaled(d.mant, d.exp, d.negative);
+}
+
+inline void LongAccumulator::add_product(double a, double b){
+    Decomposed da = decompose(a);
+    Decomposed db = decompose(b);
+    bool negative = da.negative != db.negative;
+    if (da.special || db.special){
+        bool nan_a = da.special && da.mant != (1ULL << 52);
+        bool nan_b = db.special && db.mant != (1ULL << 52);
+        if (nan_a || nan_b || da.mant == 0 || db.mant == 0) has_nan = true;   // NaN, Inf·0
+        else if (negative) has_neg_inf = true;
+        else has_pos_inf = true;
+        return;
+    }
+    add_scaled((unsigned __int128)da.mant * db.mant, da.exp + db.exp, negative);
+}
+
+double long_accumulator_dot_product(const vector<double>& a, const vector<double>& b);
+double long_accumulator_dot_product(DotView a, DotView b);
+
+// Параллельный вариант: у каждого потока свой аккумулятор, слияние точное,
+// поэтому результат совпадает с последовательным при любом числе потоков
+double long_accumulator_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads = 0);
+double long_accumulator_dot_product_parallel(DotView a, DotView b, size_t threads = 0);
+
@@ -0,0 +1,36 @@
+#pragma once
+#include "dot_view.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Скалярное произведение векторов float и 16-битных форматов.
+//
+// Произведение двух float точно в double (24 + 24 бита мантиссы, экспонента
+// от 2^-298 до 2^256), поэтому точный путь дешевле, чем у double: блок
+// произведений считается SIMD-расширением float → double, а целые мантиссы
+// (не больше 48 бит) копятся в int64-корзинах по экспоненте. Корзины раз в
+// 2^15 произведений сбрасываются в LongAccumulator. Результат корректно
+// округляется к double или к float (без двойного округления).
+
+// Хранение 16-битных чисел в uint16_t
+enum class HalfFormat {
+    Binary16,   // IEEE 754 half: 1 + 5 + 10 бит
+    BFloat16    // bfloat16: старшие 16 бит float
+};
+
+float half_to_float(uint16_t bits, HalfFormat format);
+
+double float_dot_product(const float* a, const float* b, size_t n);
+double float_dot_product(const vector<float>& a, const vector<float>& b);
+// Результат, корректно округлённый к float
+float float_dot_product_single(const float* a, const float* b, size_t n);
+
+double half_dot_product(const uint16_t* a, const uint16_t* b, size_t n, HalfFormat format);
+float half_dot_product_single(const uint16_t* a, const uint16_t* b, size_t n, HalfFormat format);
+
+// Смешанная точность: float × double. Произведение уже не помещается в
+// double, поэтому путь общий — точные произведения в длинном аккумуляторе
+double mixed_dot_product(const float* a, DotView b);
@@ -1,6 +1,51 @@
 #pragma once
+#include "dot_view.hpp"
+#include "eft.hpp"
+#include "long_accumulator.hpp"
+#include <cstdint>
 #include <vector>
 
 using namespace std;
 
+// Число независимых компенсированных цепочек. Фиксировано для всех
+// уровней SIMD, поэтому результат побитово одинаков на любом процессоре.
+const size_t MERGE_LANES = 16;
+
+// Объединение цепочек в фиксированном порядке через TwoSum
+inline DoubleDouble merge_lanes_result(const double* hi, const double* lo){
+    DoubleDouble sum{0.0, 0.0};
+    for (size_t k = 0; k < MERGE_LANES; k++){
+        dod_add(sum, hi[k], lo[k]);
+    }
+    return sum;
+}
+
 double merge_dot_product(const vector<double>& a, const vector<double>& b);
+double merge_dot_product(DotView a, DotView b);
+
+// Состояние Merge до округления (без пересчёта при переполнении) и
+// abs_sum = sum |a_i·b_i|, вычисленная в тех же цепочках. Нужна для
+// апостериорной оценки погрешности в auto_dot_product.
+DoubleDouble merge_dot_product_bounded(DotView a, DotView b, double& abs_sum);
+
+// Потоковый вариант для входа, приходящего порциями. Каждая порция
+// считается как merge_dot_product, её частичная сумма (hi, lo) добавляется
+// в длинный аккумулятор точно. Результат зависит только от разбиения на
+// порции, но не от порядка add/merge. Формат serialize — как у LongAccumulator.
+class MergeAccumulator {
+public:
+    void add(DotView a, DotView b);
+    void merge(const MergeAccumulator& other){ exact.merge(other.exact); }
+    double finalize() const { return exact.round(); }
+
+    vector<uint8_t> serialize() const { return exact.serialize(); }
+    bool deserialize(const uint8_t* data, size_t size){ return exact.deserialize(data, size); }
+
+private:
+    LongAccumulator exact;
+};
+
+// Параллельный вариант: вход делится на блоки PARALLEL_BLOCK, частичные
+// суммы блоков складываются точно. Результат одинаков при любом числе потоков.
+double merge_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads = 0);
+double merge_dot_product_parallel(DotView a, DotView b, size_t threads = 0);
@@ -0,0 +1,34 @@
+#pragma once
+#include "dot_view.hpp"
+#include <vector>
+
+using namespace std;
+
+// Точное скалярное произведение для входов с узким диапазоном экспонент.
+// Вектор идёт блоками по NARROW_BLOCK элементов. Для каждого блока сначала
+// находится диапазон ключей e_a + e_b ненулевых произведений. Если он не
+// шире NARROW_WINDOW, все точные произведения — целые кратные младшего
+// веса блока шириной не больше 106 + NARROW_WINDOW бит. Тогда обе части
+// TwoProd раскладываются на 40-битные разряды с фиксированными границами
+// и копятся в double как точные целые: без переносов, без ветвлений по
+// элементам и без длинного аккумулятора, в ядрах AVX2/AVX-512. Суммы
+// разрядов блока переносятся в длинный аккумулятор, в конце — одно
+// округление.
+//
+// Блоки шире окна, со спецзначениями, субнормалями или у краёв диапазона
+// (произведения меньше 2^-970 или больше 2^956) считаются обычным длинным
+// аккумулятором. Поэтому результат всегда корректно округлён и побитово
+// совпадает с long_accumulator_dot_product.
+
+const size_t NARROW_BLOCK = 1024;
+const int NARROW_WINDOW = 120;
+
+// Сколько блоков прошло быстрым путём, а сколько — длинным аккумулятором
+struct NarrowDotInfo {
+    size_t blocks;
+    size_t fallback_blocks;
+};
+
+double narrow_dot_product(const vector<double>& a, const vector<double>& b);
+double narrow_dot_product(DotView a, DotView b);
+double narrow_dot_product(DotView a, DotView b, NarrowDotInfo& info);
@@ -0,0 +1,40 @@
+#pragma once
+#include "dot_view.hpp"
+#include <vector>
+
+using namespace std;
+
+// Сумма квадратов и евклидова норма. В отличие от вызова скалярного
+// произведения с a == b, вектор читается один раз, и используется то, что
+// квадраты неотрицательны (взаимного уничтожения нет), а экспонента
+// квадрата — удвоенная экспонента числа.
+//
+// Точный путь: целая мантисса m (53 бита) возводится в квадрат и копится в
+// __int128-корзине по экспоненте самого числа — таблица вдвое короче, чем
+// у произведений, без TwoProd и без знака. Раз в 2^22 элементов корзины
+// сбрасываются в длинный аккумулятор.
+//
+// Компенсированный путь: 16 цепочек Dot2 (как у Merge) по квадратам,
+// масштабированным по Блю: |x| > 2^486 — со множителем 2^-538, 0 < |x| <
+// 2^-511 — с 2^537, остальные без масштаба. Промежуточные суммы не
+// переполняются и не теряют субнормали. Блоки только со средними числами
+// идут в SIMD-ядро, результат побитово не зависит от процессора.
+
+// Корректно округлённая sum x_i^2 (переполнение — +Inf, как у результата)
+double sum_of_squares(DotView x);
+double sum_of_squares(const vector<double>& x);
+
+// Компенсированная сумма квадратов: относительная погрешность около u + n·u²
+double sum_of_squares_compensated(DotView x);
+double sum_of_squares_compensated(const vector<double>& x);
+
+// Корректно округлённая ||x||_2 = sqrt(sum x_i^2) — точная сумма, затем
+// корректное округление корня. Переполняется только тогда, когда сама
+// норма больше DBL_MAX.
+double norm2(DotView x);
+double norm2(const vector<double>& x);
+
+// Масштабированная компенсированная норма: один проход, без переполнения
+// и потери точности на краях диапазона, ошибка — около одного ulp
+double norm2_compensated(DotView x);
+double norm2_compensated(const vector<double>& x);
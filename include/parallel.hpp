@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+// Размер блока для компенсированных (неточных) алгоритмов. Разбиение
+// входа зависит только от его длины, поэтому результат не зависит от
+// числа потоков.
+const size_t PARALLEL_BLOCK = 1 << 16;
+
+// Число потоков по умолчанию (threads = 0 в параллельных функциях)
+size_t default_thread_count();
+
+// Выполняет task(i) для всех i из [0, count), используя не больше threads
+// потоков общего пула (включая вызывающий). Вложенные вызовы из задачи
+// выполняются последовательно.
+void parallel_for(size_t count, size_t threads, const function<void(size_t)>& task);
@@ -1,6 +1,13 @@
 #pragma once
+#include "dot_view.hpp"
 #include <vector>
 
 using namespace std;
 
-double pichat_dot_product(const vector<double>& a, const vector<double>& b);
\ No newline at end of file
+// Сумма произведений a[i]*b[i] (округлённых) с корректным округлением:
+// проходы каскада TwoSum повторяются, пока остатки могут изменить vec[0]
+double pichat_dot_product(const vector<double>& a, const vector<double>& b);
+double pichat_dot_product(DotView a, DotView b);
+
+// Буфер произведений берётся из workspace; без него — из workspace потока
+double pichat_dot_product(DotView a, DotView b, DotWorkspace& workspace);
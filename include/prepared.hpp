@@ -0,0 +1,64 @@
+#pragma once
+#include "dot_view.hpp"
+#include <vector>
+
+using namespace std;
+
+// Подготовленный операнд для вектора, который умножается на тысячи других
+// (вектор весов, запрос). Всё, что зависит только от него, считается один
+// раз при построении:
+//
+// - непрерывная копия значений: SIMD-ядра работают и тогда, когда исходный
+//   вектор — столбец матрицы или файла .dotv с шагом;
+// - половины Вельткампа x = high + low (по 26 бит): TwoProd по Деккеру без
+//   FMA. Нужны только на уровне SSE2 — у таких процессоров нет FMA, и fma()
+//   из libm программная, сотни тактов на элемент. На других уровнях они не
+//   считаются и память не занимают;
+// - диапазон двоичных порядков ненулевых элементов и флаги NaN, Inf и
+//   субнормалей. По ним ядра заранее выбирают путь: NaN даёт NaN без
+//   прохода, Inf сразу ведёт к точному пути, а TwoProd по Деккеру
+//   допустим, только если сумма порядков не выходит за пределы, где он
+//   точен.
+//
+// Результаты побитово совпадают с обычными вызовами на тех же значениях
+// (при NaN в операнде — какой-то NaN, как и у обычных вызовов).
+class PreparedVector {
+public:
+    PreparedVector() {}
+    explicit PreparedVector(DotView x);
+    explicit PreparedVector(const vector<double>& x) : PreparedVector(DotView(x)) {}
+
+    size_t size() const { return values.size(); }
+    DotView view() const { return DotView(values); }
+    // Половины есть, только если has_halves()
+    bool has_halves() const { return !high.empty() || values.empty(); }
+    const double* high_part() const { return high.data(); }
+    const double* low_part() const { return low.data(); }
+
+    // floor(log2 |x|) по ненулевым конечным элементам; для вектора без
+    // таких элементов min_exponent() > max_exponent()
+    int min_exponent() const { return min_exp; }
+    int max_exponent() const { return max_exp; }
+    bool has_nan() const { return nan; }
+    bool has_inf() const { return inf; }
+    bool has_subnormal() const { return subnormal; }
+    // Половины точны: нет спецзначений и |x| < 2^995 (без переполнения 2^27·x)
+    bool splittable() const { return !nan && !inf && max_exp < 995; }
+
+private:
+    vector<double> values;
+    vector<double> high;
+    vector<double> low;
+    int min_exp = 1 << 20;
+    int max_exp = -(1 << 20);
+    bool nan = false;
+    bool inf = false;
+    bool subnormal = false;
+};
+
+// Скалярные произведения с подготовленным первым операндом. Результат
+// побитово совпадает с merge_dot_product(a.view(), b) и
+// auto_dot_product(a.view(), b); операнд с шагом b собирается в
+// непрерывный буфер рабочей памяти потока.
+double merge_dot_product(const PreparedVector& a, DotView b);
+double auto_dot_product(const PreparedVector& a, DotView b);
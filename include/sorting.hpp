@@ -1,6 +1,11 @@
 #pragma once
+#include "dot_view.hpp"
 #include <vector>
 
 using namespace std;
 
-double sorting_dot_product(const vector<double>& a, const vector<double>& b);
\ No newline at end of file
+double sorting_dot_product(const vector<double>& a, const vector<double>& b);
+double sorting_dot_product(DotView a, DotView b);
+
+// Буфер произведений берётся из workspace; без него — из workspace потока
+double sorting_dot_product(DotView a, DotView b, DotWorkspace& workspace);
@@ -0,0 +1,39 @@
+#pragma once
+#include "dot_view.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Разреженный операнд (строка CSR или вектор COO): nnz пар
+// (index[k], value[k]). Индексы не повторяются; для sparse·sparse они
+// должны возрастать, для sparse·dense порядок любой и index[k] < b.size.
+struct SparseView {
+    const size_t* index;
+    const double* value;
+    size_t nnz;
+
+    SparseView(const size_t* index, const double* value, size_t nnz)
+        : index(index), value(value), nnz(nnz) {}
+    // invalid_argument, если длины index и value различаются
+    SparseView(const vector<size_t>& index, const vector<double>& value)
+        : index(index.data()), value(value.data()), nnz(checked_size(index, value)) {}
+
+private:
+    static size_t checked_size(const vector<size_t>& index, const vector<double>& value){
+        if (index.size() != value.size()) throw invalid_argument("SparseView: index.size() != value.size()");
+        return value.size();
+    }
+};
+
+// sparse·dense: сбор b[index[k]] без уплотнения a. Результат побитово
+// совпадает с тем же алгоритмом на плотных векторах из value[k] и
+// b[index[k]], то есть стоимость O(nnz), а не O(размерность).
+double merge_dot_product(SparseView a, DotView b);
+double kobbelt_dot_product(SparseView a, DotView b);
+
+// sparse·sparse: слияние двух отсортированных списков индексов; в сумму
+// идут только совпавшие индексы, в порядке возрастания
+double merge_dot_product(SparseView a, SparseView b);
+double kobbelt_dot_product(SparseView a, SparseView b);
@@ -0,0 +1,59 @@
+#pragma once
+#include "dot_view.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Двоичный файл векторов (.dotv) — заголовок и сырые double little-endian:
+//
+//   смещение  размер  поле
+//   0         4       "DOTV"
+//   4         4       версия (1), uint32
+//   8         8       rows — число строк, uint64
+//   16        4       columns — число столбцов, uint32
+//   20        4       data_offset — начало данных, кратно 8 и >= 32, uint32
+//   24        8       резерв (0)
+//
+// Данные — rows·columns double по строкам: элемент (r, c) лежит по смещению
+// data_offset + 8·(r·columns + c). Один столбец — обычный вектор; несколько
+// столбцов читаются как DotView с шагом columns, без копирования.
+const size_t VECTOR_FILE_HEADER_SIZE = 32;
+
+// Файл, отображённый в память только для чтения. Представления column()
+// действительны, пока объект жив.
+class MappedVectorFile {
+public:
+    MappedVectorFile() = default;
+    ~MappedVectorFile();
+    MappedVectorFile(const MappedVectorFile&) = delete;
+    MappedVectorFile& operator=(const MappedVectorFile&) = delete;
+
+    // false и описание в error(), если файл не открыт или формат неверен
+    bool open(const string& path);
+    void close();
+
+    size_t rows() const { return row_count; }
+    size_t columns() const { return column_count; }
+    // Пустое представление, если c >= columns()
+    DotView column(size_t c) const;
+
+    // Подсказка ядру: данные будут прочитаны один раз подряд — агрессивное
+    // упреждающее чтение и ранняя подгрузка всего диапазона
+    void advise_sequential() const;
+
+    const string& error() const { return message; }
+
+private:
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    const double* data = nullptr;
+    size_t row_count = 0;
+    size_t column_count = 0;
+    string message;
+};
+
+// Записывает столбцы одинаковой длины в файл формата .dotv
+bool write_vector_file(const string& path, const vector<DotView>& columns);
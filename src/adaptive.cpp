@@ -0,0 +1,71 @@
+#include "adaptive.hpp"
+#include "eft.hpp"
+#include "instrument.hpp"
+#include "merge.hpp"
+#include "narrow.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+static const double UNIT_ROUNDOFF = 0x1p-53;
+
+// Граница |hi + lo - sum a_i·b_i| для прохода Merge (или одной цепочки
+// Dot2) по n элементам. Цепочка Dot2 длины m ошибается не больше чем на gamma_m^2 · S
+// (Ogita, Rump, Oishi), слияние 16 цепочек добавляет gamma_32 · u · S;
+// обе части покрывает 2·gamma_{n+64}^2 · S. Абсолютный член учитывает
+// ошибки TwoProd и сложений ниже порога субнормалей. Множитель
+// (1 + 2^-40) поглощает округления при вычислении самой границы.
+double dot2_error_bound(size_t n, double abs_sum){
+    double nu = (double)(n + 64) * UNIT_ROUNDOFF;
+    if (!(nu < 0.5)) return INFINITY;
+    double gamma = nu / (1.0 - nu);
+    // abs_sum посчитана в тех же цепочках с округлением: занижена не
+    // больше чем в (1 + gamma)
+    double abs_upper = abs_sum * (1.0 + 2.0 * gamma);
+    double underflow = ldexp((double)(2 * n + 64), -1074);
+    return (2.0 * gamma * gamma * abs_upper + underflow) * (1.0 + 0x1p-40);
+}
+
+// Точное значение лежит в [hi + lo - bound, hi + lo + bound]. Сдвиги
+// lo -+ bound округляются, поэтому граница расширяется на ulp их суммы;
+// тогда fl(hi + low) и fl(hi + high) окружают точное значение, и по
+// монотонности округления их совпадение означает, что и точное
+// значение округляется в то же число.
+bool certified_round(double hi, double lo, double bound, double& result){
+    if (!isfinite(hi) || !isfinite(lo) || !isfinite(bound)) return false;
+    double widened = (bound + fabs(lo) * 0x1p-52) * (1.0 + 0x1p-50);
+    double low = hi + (lo - widened);
+    double high = hi + (lo + widened);
+    if (low != high || !isfinite(low)) return false;
+    result = low;
+    return true;
+}
+
+double auto_dot_product(DotView a, DotView b, AutoDotInfo& info){
+    DOT_INSTRUMENT_CALL("Auto", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    size_t n = a.size;
+    double abs_sum;
+    DoubleDouble sum = merge_dot_product_bounded(a, b, abs_sum);
+    double bound = dot2_error_bound(n, abs_sum);
+
+    DOT_INSTRUMENT_PHASE(Finalize);
+    double result = 0.0;
+    bool certified = certified_round(sum.hi, sum.lo, bound, result);
+    if (!certified) result = narrow_dot_product(a, b);
+
+    info.certified = certified;
+    info.error_bound = bound;
+    info.condition = abs_sum == 0.0 ? 1.0 : abs_sum / fabs(result);
+    return DOT_INSTRUMENT_RESULT(result);
+}
+
+double auto_dot_product(DotView a, DotView b){
+    AutoDotInfo info;
+    return auto_dot_product(a, b, info);
+}
+
+double auto_dot_product(const vector<double>& a, const vector<double>& b){
+    return auto_dot_product(DotView(a), DotView(b));
+}
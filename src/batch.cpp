@@ -0,0 +1,176 @@
+#include "batch.hpp"
+#include "cpu_dispatch.hpp"
+#include "eft.hpp"
+#include "eft_simd.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_HAVE_X86 1
+#endif
+
+using namespace std;
+
+// Пакетное ядро: count пар длины n (для N != 0 длина известна при компиляции)
+typedef void (*BatchKernel)(const DotPair*, size_t, size_t, double*);
+
+static void fma_batch_scalar(const DotPair* pairs, size_t count, size_t n, double* out){
+    for (size_t k = 0; k < count; k++){
+        out[k] = fma_dot_product(DotView(pairs[k].a, n), DotView(pairs[k].b, n));
+    }
+}
+
+static void merge_batch_scalar(const DotPair* pairs, size_t count, size_t n, double* out){
+    for (size_t k = 0; k < count; k++){
+        out[k] = merge_dot_product(DotView(pairs[k].a, n), DotView(pairs[k].b, n));
+    }
+}
+
+#ifdef BATCH_HAVE_X86
+// Четыре пары в одном векторе: разряд j регистра — пара k + j
+struct Quad {
+    const double* a[4];
+    const double* b[4];
+};
+
+// Элементы i..i+3 четырёх строк с транспонированием 4x4: col[j] — элемент
+// i + j всех четырёх строк
+__attribute__((target("avx2,fma")))
+static inline void load_transposed(const double* const* rows, size_t i, __m256d* col){
+    __m256d r0 = _mm256_loadu_pd(rows[0] + i);
+    __m256d r1 = _mm256_loadu_pd(rows[1] + i);
+    __m256d r2 = _mm256_loadu_pd(rows[2] + i);
+    __m256d r3 = _mm256_loadu_pd(rows[3] + i);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    col[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+    col[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+    col[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+    col[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256d load_column(const double* const* rows, size_t i){
+    return _mm256_set_pd(rows[3][i], rows[2][i], rows[1][i], rows[0][i]);
+}
+
+static inline Quad quad_at(const DotPair* pairs){
+    Quad q;
+    for (int j = 0; j < 4; j++){
+        q.a[j] = pairs[j].a;
+        q.b[j] = pairs[j].b;
+    }
+    return q;
+}
+
+template<size_t N>
+__attribute__((target("avx2,fma")))
+static void fma_batch_avx2(const DotPair* pairs, size_t count, size_t n_runtime, double* out){
+    const size_t n = N ? N : n_runtime;
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4){
+        Quad q = quad_at(pairs + k);
+        __m256d sum = _mm256_setzero_pd();
+        size_t i = 0;
+#pragma GCC unroll 16
+        for (; i + 4 <= n; i += 4){
+            __m256d ca[4], cb[4];
+            load_transposed(q.a, i, ca);
+            load_transposed(q.b, i, cb);
+            for (int j = 0; j < 4; j++) sum = _mm256_fmadd_pd(ca[j], cb[j], sum);
+        }
+        for (; i < n; i++) sum = _mm256_fmadd_pd(load_column(q.a, i), load_column(q.b, i), sum);
+        _mm256_storeu_pd(out + k, sum);
+    }
+    fma_batch_scalar(pairs + k, count - k, n, out + k);
+}
+
+// Свёртка цепочек и dod_get для четырёх пар — как merge_lanes_result
+__attribute__((target("avx2,fma")))
+static inline __m256d merge_lanes_quad(const __m256d* h, const __m256d* l){
+    __m256d sum_hi = _mm256_setzero_pd();
+    __m256d sum_lo = _mm256_setzero_pd();
+    for (size_t k = 0; k < MERGE_LANES; k++){
+        __m256d e1 = two_sum_avx2(sum_hi, h[k]);
+        sum_lo = two_sum_avx2(sum_hi, _mm256_add_pd(_mm256_add_pd(e1, l[k]), sum_lo));
+    }
+    __m256d result = _mm256_add_pd(sum_hi, sum_lo);
+    __m256d residual = _mm256_add_pd(_mm256_sub_pd(sum_hi, result), sum_lo);
+    return _mm256_add_pd(result, residual);
+}
+
+template<size_t N>
+__attribute__((target("avx2,fma")))
+static void merge_batch_avx2(const DotPair* pairs, size_t count, size_t n_runtime, double* out){
+    const size_t n = N ? N : n_runtime;
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4){
+        Quad q = quad_at(pairs + k);
+        __m256d h[MERGE_LANES], l[MERGE_LANES];
+        for (size_t lane = 0; lane < MERGE_LANES; lane++){
+            h[lane] = _mm256_setzero_pd();
+            l[lane] = _mm256_setzero_pd();
+        }
+        size_t i = 0;
+#pragma GCC unroll 16
+        for (; i + 4 <= n; i += 4){
+            __m256d ca[4], cb[4];
+            load_transposed(q.a, i, ca);
+            load_transposed(q.b, i, cb);
+            for (size_t j = 0; j < 4; j++){
+                size_t lane = (i + j) % MERGE_LANES;
+                dot2_step_avx2(h[lane], l[lane], ca[j], cb[j]);
+            }
+        }
+        for (; i < n; i++){
+            size_t lane = i % MERGE_LANES;
+            dot2_step_avx2(h[lane], l[lane], load_column(q.a, i), load_column(q.b, i));
+        }
+        _mm256_storeu_pd(out + k, merge_lanes_quad(h, l));
+        // Переполнение в цепочке — пересчёт этой пары как в merge_dot_product
+        for (size_t j = 0; j < 4; j++){
+            if (!isfinite(out[k + j])) out[k + j] = merge_dot_product(DotView(q.a[j], n), DotView(q.b[j], n));
+        }
+    }
+    merge_batch_scalar(pairs + k, count - k, n, out + k);
+}
+
+// Ядра для типичных коротких длин собраны отдельно — с полностью
+// развёрнутыми циклами и цепочками в регистрах
+template<template<size_t> class Kernels>
+static BatchKernel select_for_length(size_t n){
+    switch (n){
+        case 8:  return Kernels<8>::avx2;
+        case 16: return Kernels<16>::avx2;
+        case 32: return Kernels<32>::avx2;
+        case 64: return Kernels<64>::avx2;
+        default: return Kernels<0>::avx2;
+    }
+}
+
+template<size_t N> struct FmaKernels   { static constexpr BatchKernel avx2 = fma_batch_avx2<N>; };
+template<size_t N> struct MergeKernels { static constexpr BatchKernel avx2 = merge_batch_avx2<N>; };
+#endif
+
+// AVX-512 использует те же ядра: на коротких векторах транспонирование
+// восьми строк не окупается
+static bool batch_use_avx2(){
+    static const bool use = detect_simd_level() >= SimdLevel::AVX2;
+    return use;
+}
+
+void fma_dot_product_batch(const DotPair* pairs, size_t count, size_t n, double* out){
+#ifdef BATCH_HAVE_X86
+    if (batch_use_avx2()) return select_for_length<FmaKernels>(n)(pairs, count, n, out);
+#endif
+    fma_batch_scalar(pairs, count, n, out);
+}
+
+void merge_dot_product_batch(const DotPair* pairs, size_t count, size_t n, double* out){
+#ifdef BATCH_HAVE_X86
+    if (batch_use_avx2()) return select_for_length<MergeKernels>(n)(pairs, count, n, out);
+#endif
+    merge_batch_scalar(pairs, count, n, out);
+}
@@ -0,0 +1,257 @@
+#include "binned.hpp"
+#include "digit_split.hpp"
+#include "digits.hpp"
+#include "instrument.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+static_assert(BinnedAccumulator::BINS + 1 <= SPLIT_MAX_DIGITS, "binned: окно шире ядер разрядов");
+static_assert(BinnedAccumulator::BIN_BITS <= 40, "binned: слагаемые корзины шире 2^(β+41)");
+
+// Ключ k = e_a + e_b (смещённые экспоненты, у субнормали 0): |a·b| < 2^(k-2044).
+// Корзина ключа T: β_T <= k - 2045 < β_T + BIN_BITS, так что
+// |a·b| < 2^(β_T + BIN_BITS), а у нормальных множителей β_T <= log2|a·b| + 1
+static const int KEY_TOP_BIAS = 2045;
+
+// Номера старшей корзины окна для ключей от 0 до 2·2046
+static const int MIN_TOP = (0 - KEY_TOP_BIAS - (-2148)) / BinnedAccumulator::BIN_BITS;
+static const int MAX_TOP = (2 * 2046 - KEY_TOP_BIAS - (-2148)) / BinnedAccumulator::BIN_BITS;
+
+// Константы выделения 1.5·2^(β_top+52) конечны при β_top <= 970. Нижняя
+// граница окна не ниже 2^-900: оставшиеся в блоке произведения (см.
+// add_block) не меньше 2^-902, их ошибка TwoProd — кратное 2^-1008, так что
+// обе части TwoProd точны и нормальны. Меньшие произведения встречаются
+// только у субнормальных множителей; они меньше 2^-968 и округляются в
+// ноль. Окно вне этих границ сдвигается масштабом множителей 2^s.
+static const int MAX_UNSCALED_TOP = 970;
+static const int MIN_UNSCALED_TOP = -900 + BinnedAccumulator::BIN_BITS * (BinnedAccumulator::BINS - 1);
+
+static inline uint64_t abs_bits(double x){
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    return bits & ~(1ULL << 63);
+}
+
+// Корзины ниже нового окна отбрасываются целиком. Сумма корзин слагаемого
+// от j и выше — его округление до кратного 2^β_j и от старших корзин не
+// зависит, поэтому остаток — в точности то, что дало бы новое окно с самого
+// начала.
+void BinnedAccumulator::shift_window(int new_top){
+    int d = top < 0 ? BINS : new_top - top;
+    for (int k = BINS - 1; k >= 0; k--) bins[k] = k >= d ? bins[k - d] : 0;
+    top = new_top;
+}
+
+// Блок не длиннее SPLIT_BLOCK с единичным шагом
+void BinnedAccumulator::add_block(const double* a, const double* b, size_t n){
+    double copy_a[SPLIT_BLOCK], copy_b[SPLIT_BLOCK];
+    KeyRange range;
+    scan_keys(a, b, n, range);
+    if (range.max_exp == 2047){
+        // Inf и NaN — только во флагах, их пары в копии обнуляются
+        for (size_t i = 0; i < n; i++){
+            copy_a[i] = a[i];
+            copy_b[i] = b[i];
+            if (isfinite(a[i]) && isfinite(b[i])) continue;
+            if (isnan(a[i]) || isnan(b[i]) || a[i] == 0 || b[i] == 0) has_nan = true;   // NaN, Inf·0
+            else if (signbit(a[i]) != signbit(b[i])) has_neg_inf = true;
+            else has_pos_inf = true;
+            copy_a[i] = copy_b[i] = 0.0;
+        }
+        a = copy_a;
+        b = copy_b;
+        range = KeyRange();
+        scan_keys(a, b, n, range);
+    }
+    if (range.min_key > range.max_key) return;                  // все произведения нулевые
+    int block_top = ((int)range.max_key - KEY_TOP_BIAS - MIN_EXP) / BIN_BITS;
+    if (block_top > top) shift_window(block_top);
+
+    int beta_top = MIN_EXP + BIN_BITS * top;
+    int beta_low = beta_top - BIN_BITS * (BINS - 1);
+    int scale = beta_top > MAX_UNSCALED_TOP ? MAX_UNSCALED_TOP - beta_top
+              : beta_top < MIN_UNSCALED_TOP ? MIN_UNSCALED_TOP - beta_top : 0;
+    // При ключе не больше drop_key |a·b| < 2^(β_low - 1): вклад ноль, и пара
+    // обнуляется. Так блок с широким разбросом или субнормалями идёт тем же
+    // путём без медленных на x86 субнормальных операций.
+    int drop_key = beta_low - 1 + KEY_TOP_BIAS - 1;
+    if (scale != 0 || range.min_key <= drop_key || range.min_exp == 0){
+        // 2^s — произведение двух представимых степеней. Вниз масштабируется
+        // a: уходит в субнормали оно только у отброшенных пар. Вверх —
+        // меньший по модулю множитель, он не переполняется. Оставшаяся
+        // субнормаль (только при s >= 0) умножается на 2^s или, при s = 0,
+        // на 2^64 за счёт второго множителя: он не меньше 2^121.
+        const double f1 = ldexp(1.0, scale / 2), f2 = ldexp(1.0, scale - scale / 2);
+        int shift = (scale > 0 ? scale : 64) - 1074;
+        const double g1 = ldexp(1.0, shift / 2), g2 = ldexp(1.0, shift - shift / 2);
+        for (size_t i = 0; i < n; i++){
+            // Выбор — по битам: операции над отброшенными субнормалями медленны
+            uint64_t x = abs_bits(a[i]), y = abs_bits(b[i]);
+            if ((int)(x >> 52) + (int)(y >> 52) <= drop_key){
+                copy_a[i] = copy_b[i] = 0.0;
+                continue;
+            }
+            bool scale_a = scale < 0 || x <= y;
+            double u = scale_a ? a[i] : b[i], v = scale_a ? b[i] : a[i];
+            uint64_t bits = scale_a ? x : y;
+            if (bits >> 52 == 0){
+                double m = (double)bits * g1 * g2;
+                u = signbit(u) ? -m : m;
+                if (scale == 0) v *= 0x1p-64;
+            } else if (scale != 0){
+                u = u * f1 * f2;
+            }
+            copy_a[i] = u;
+            copy_b[i] = v;
+        }
+        a = copy_a;
+        b = copy_b;
+    }
+
+    // Разряд 0 — остаток ниже окна, разряд BINS - k — корзина top - k
+    double sigma[BINS + 1], d[BINS + 1] = {};
+    for (int j = 1; j <= BINS; j++) sigma[j] = ldexp(1.5, beta_low + scale + BIN_BITS * (j - 1) + 52);
+    split_digits(a, b, n, BINS + 1, sigma, d);
+    for (int j = 1; j <= BINS; j++) bins[BINS - j] += (int64_t)ldexp(d[j], -(beta_low + scale + BIN_BITS * (j - 1)));
+}
+
+void BinnedAccumulator::add_product(double a, double b){
+    add_block(&a, &b, 1);
+}
+
+void BinnedAccumulator::add(DotView a, DotView b){
+    double gathered_a[SPLIT_BLOCK], gathered_b[SPLIT_BLOCK];
+    for (size_t begin = 0; begin < a.size; begin += SPLIT_BLOCK){
+        size_t n = min(SPLIT_BLOCK, a.size - begin);
+        DotView block_a = a.slice(begin, n), block_b = b.slice(begin, n);
+        const double* pa = block_a.data;
+        const double* pb = block_b.data;
+        if (!block_a.contiguous()){
+            for (size_t i = 0; i < n; i++) gathered_a[i] = block_a[i];
+            pa = gathered_a;
+        }
+        if (!block_b.contiguous()){
+            for (size_t i = 0; i < n; i++) gathered_b[i] = block_b[i];
+            pb = gathered_b;
+        }
+        add_block(pa, pb, n);
+    }
+}
+
+void BinnedAccumulator::merge(const BinnedAccumulator& other){
+    has_nan |= other.has_nan;
+    has_pos_inf |= other.has_pos_inf;
+    has_neg_inf |= other.has_neg_inf;
+    if (other.top < 0) return;
+    if (other.top > top) shift_window(other.top);
+    int d = top - other.top;
+    for (int k = 0; k + d < BINS; k++) bins[k + d] += other.bins[k];
+}
+
+double BinnedAccumulator::finalize() const {
+    if (has_nan || (has_pos_inf && has_neg_inf)) return numeric_limits<double>::quiet_NaN();
+    if (has_pos_inf) return numeric_limits<double>::infinity();
+    if (has_neg_inf) return -numeric_limits<double>::infinity();
+    if (top < 0) return 0.0;
+
+    // Сумма корзин — целое число в 32-битных разрядах d[0..] с весом
+    // младшего 2^base; корзина top - k начинается с бита BIN_BITS·(BINS-1-k)
+    const int DIGITS = (BIN_BITS * (BINS - 1) + 128) / EXACT_DIGIT_BITS + 2;
+    int base = (top - BINS + 1) * BIN_BITS + MIN_EXP;
+    int64_t d[DIGITS] = {};
+    for (int k = 0; k < BINS; k++){
+        __int128 v = bins[k];
+        int bit = BIN_BITS * (BINS - 1 - k);
+        int index = bit / EXACT_DIGIT_BITS, shift = bit % EXACT_DIGIT_BITS;
+        d[index] += (int64_t)(v & (((__int128)1 << (EXACT_DIGIT_BITS - shift)) - 1)) << shift;
+        v >>= EXACT_DIGIT_BITS - shift;
+        for (index++; v != 0 && v != -1; index++){
+            d[index] += (int64_t)(uint32_t)v;
+            v >>= EXACT_DIGIT_BITS;
+        }
+        d[index] += (int64_t)v;
+    }
+    return round_digits(d, DIGITS, base);
+}
+
+// Формат: "BACC", версия, флаги спецзначений, номер старшей корзины
+// (int32), затем суммы корзин от старшей к младшей как int128
+static const uint8_t SERIAL_MAGIC[4] = {'B', 'A', 'C', 'C'};
+static const uint8_t SERIAL_VERSION = 2;
+
+vector<uint8_t> BinnedAccumulator::serialize() const {
+    vector<uint8_t> out(SERIAL_MAGIC, SERIAL_MAGIC + 4);
+    out.reserve(SERIALIZED_SIZE);
+    out.push_back(SERIAL_VERSION);
+    out.push_back((uint8_t)(has_nan | has_pos_inf << 1 | has_neg_inf << 2));
+    put_le(out, (uint32_t)top, 4);
+    for (int k = 0; k < BINS; k++){
+        unsigned __int128 v = (unsigned __int128)bins[k];
+        put_le(out, (uint64_t)v, 8);
+        put_le(out, (uint64_t)(v >> 64), 8);
+    }
+    return out;
+}
+
+bool BinnedAccumulator::deserialize(const uint8_t* data, size_t size){
+    if (size != SERIALIZED_SIZE || memcmp(data, SERIAL_MAGIC, 4) != 0) return false;
+    if (data[4] != SERIAL_VERSION || (data[5] & ~7) != 0) return false;
+    BinnedAccumulator acc;
+    acc.has_nan = (data[5] & 1) != 0;
+    acc.has_pos_inf = (data[5] & 2) != 0;
+    acc.has_neg_inf = (data[5] & 4) != 0;
+    acc.top = (int32_t)(uint32_t)get_le(data + 6, 4);
+    if (acc.top != -1 && (acc.top < MIN_TOP || acc.top > MAX_TOP)) return false;
+    const uint8_t* p = data + 10;
+    for (int k = 0; k < BINS; k++, p += 16){
+        unsigned __int128 v = (unsigned __int128)get_le(p + 8, 8) << 64 | get_le(p, 8);
+        __int128 value = (__int128)v;
+        // Запас под слияния: сумма корзины далеко от переполнения int128
+        const __int128 limit = (__int128)1 << 100;
+        if (value > limit || value < -limit) return false;
+        if (acc.top < 0 && value != 0) return false;
+        acc.bins[k] = value;
+    }
+    *this = acc;
+    return true;
+}
+
+double binned_dot_product(DotView a, DotView b){
+    DOT_INSTRUMENT_CALL("Binned", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    BinnedAccumulator acc;
+    acc.add(a, b);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(acc.finalize());
+}
+
+double binned_dot_product(const vector<double>& a, const vector<double>& b){
+    return binned_dot_product(DotView(a), DotView(b));
+}
+
+double binned_dot_product_parallel(DotView a, DotView b, size_t threads){
+    DOT_INSTRUMENT_CALL("Binned MT", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    if (threads == 0) threads = default_thread_count();
+    size_t n = a.size;
+    size_t parts = max<size_t>(1, min(threads, n / PARALLEL_BLOCK));
+    vector<BinnedAccumulator> partial(parts);
+    parallel_for(parts, parts, [&](size_t p){
+        size_t begin = n * p / parts, end = n * (p + 1) / parts;
+        partial[p].add(a.slice(begin, end - begin), b.slice(begin, end - begin));
+    });
+    DOT_INSTRUMENT_PHASE(Finalize);
+    for (size_t p = 1; p < parts; p++) partial[0].merge(partial[p]);
+    return DOT_INSTRUMENT_RESULT(partial[0].finalize());
+}
+
+double binned_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads){
+    return binned_dot_product_parallel(DotView(a), DotView(b), threads);
+}
@@ -0,0 +1,42 @@
+#include "cpu_dispatch.hpp"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+static SimdLevel detect_hardware(){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+static SimdLevel detect_once(){
+    SimdLevel level = detect_hardware();
+    const char* env = getenv("DOT_PRODUCT_SIMD");
+    if (!env) return level;
+
+    SimdLevel requested = level;
+    if (strcmp(env, "scalar") == 0) requested = SimdLevel::Scalar;
+    else if (strcmp(env, "sse2") == 0) requested = SimdLevel::SSE2;
+    else if (strcmp(env, "avx2") == 0) requested = SimdLevel::AVX2;
+    else if (strcmp(env, "avx512") == 0) requested = SimdLevel::AVX512;
+    return requested < level ? requested : level;
+}
+
+SimdLevel detect_simd_level(){
+    static const SimdLevel level = detect_once();
+    return level;
+}
+
+const char* simd_level_name(SimdLevel level){
+    switch (level){
+        case SimdLevel::SSE2:   return "sse2";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default:                return "scalar";
+    }
+}
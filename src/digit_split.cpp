@@ -0,0 +1,261 @@
+#include "digit_split.hpp"
+#include "cpu_dispatch.hpp"
+#include "eft.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPLIT_HAVE_X86 1
+#endif
+
+using namespace std;
+
+static const size_t SPLIT_LANES = 16;
+
+// ── Просмотр ───────────────────────────────────────────────────────────────
+static inline uint64_t abs_bits(double x){
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    return bits & ~(1ULL << 63);
+}
+
+static void scan_scalar(const double* a, const double* b, size_t begin, size_t end, KeyRange& range){
+    for (size_t i = begin; i < end; i++){
+        uint64_t x = abs_bits(a[i]), y = abs_bits(b[i]);
+        int64_t ea = (int64_t)(x >> 52), eb = (int64_t)(y >> 52);
+        if (x != 0 && y != 0){
+            range.min_key = min(range.min_key, ea + eb);
+            range.max_key = max(range.max_key, ea + eb);
+        }
+        if (x != 0) range.min_exp = min(range.min_exp, ea);
+        if (y != 0) range.min_exp = min(range.min_exp, eb);
+        range.max_exp = max(range.max_exp, max(ea, eb));
+    }
+}
+
+// ── Разряды ────────────────────────────────────────────────────────────────
+// Выделение по Руму сверху вниз, см. digit_split.hpp
+template<int D>
+static inline void digits_add(double* d, const double* sigma, double v){
+    for (int j = D - 1; j > 0; j--){
+        double q = (v + sigma[j]) - sigma[j];
+        d[j] += q;
+        v -= q;
+    }
+    d[0] += v;
+}
+
+template<int D>
+static void digits_scalar(const double* a, const double* b, size_t begin, size_t end, const double* sigma, double* d){
+    for (size_t i = begin; i < end; i++){
+        pair<double, double> p = exact_multiply(a[i], b[i]);
+        digits_add<D>(d, sigma, p.first);
+        digits_add<D>(d, sigma, p.second);
+    }
+}
+
+// Ядра обрабатывают первые n элементов (n кратно SPLIT_LANES); ядро
+// разрядов прибавляет к d суммы по всем своим цепочкам
+typedef void (*ScanKernel)(const double*, const double*, size_t, KeyRange&);
+typedef void (*DigitsKernel)(const double*, const double*, size_t, const double*, double*);
+
+static void scan_kernel_scalar(const double* a, const double* b, size_t n, KeyRange& range){
+    scan_scalar(a, b, 0, n, range);
+}
+
+template<int D>
+static void digits_kernel_scalar(const double* a, const double* b, size_t n, const double* sigma, double* d){
+    digits_scalar<D>(a, b, 0, n, sigma, d);
+}
+
+#ifdef SPLIT_HAVE_X86
+// Ключи и экспоненты в 64-битных разрядах меньше 2^21, старшие 32 бита
+// нулевые — хватает знаковых min/max по 32 битам
+__attribute__((target("avx2")))
+static void scan_kernel_avx2(const double* a, const double* b, size_t n, KeyRange& range){
+    const __m256i abs_mask = _mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL);
+    const __m256i big = _mm256_set1_epi64x(1 << 20);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i min_key = big, max_key = zero, min_exp = big, max_exp = zero;
+    for (size_t i = 0; i < n; i += 4){
+        __m256i x = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a + i)), abs_mask);
+        __m256i y = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(b + i)), abs_mask);
+        __m256i ex = _mm256_srli_epi64(x, 52), ey = _mm256_srli_epi64(y, 52);
+        __m256i zx = _mm256_cmpeq_epi64(x, zero), zy = _mm256_cmpeq_epi64(y, zero);
+        __m256i zp = _mm256_or_si256(zx, zy);
+        __m256i key = _mm256_add_epi64(ex, ey);
+        min_key = _mm256_min_epi32(min_key, _mm256_blendv_epi8(key, big, zp));
+        max_key = _mm256_max_epi32(max_key, _mm256_andnot_si256(zp, key));
+        min_exp = _mm256_min_epi32(min_exp, _mm256_min_epi32(_mm256_blendv_epi8(ex, big, zx),
+                                                             _mm256_blendv_epi8(ey, big, zy)));
+        max_exp = _mm256_max_epi32(max_exp, _mm256_max_epi32(ex, ey));
+    }
+    alignas(32) int64_t v[4][4];
+    _mm256_store_si256((__m256i*)v[0], min_key);
+    _mm256_store_si256((__m256i*)v[1], max_key);
+    _mm256_store_si256((__m256i*)v[2], min_exp);
+    _mm256_store_si256((__m256i*)v[3], max_exp);
+    for (int k = 0; k < 4; k++){
+        KeyRange lane;
+        lane.min_key = v[0][k];
+        lane.max_key = v[1][k];
+        lane.min_exp = v[2][k];
+        lane.max_exp = v[3][k];
+        range.merge(lane);
+    }
+}
+
+template<int D>
+__attribute__((target("avx2,fma")))
+static inline void digits_add_avx2(__m256d* d, const __m256d* sigma, __m256d v){
+    for (int j = D - 1; j > 0; j--){
+        __m256d q = _mm256_sub_pd(_mm256_add_pd(v, sigma[j]), sigma[j]);
+        d[j] = _mm256_add_pd(d[j], q);
+        v = _mm256_sub_pd(v, q);
+    }
+    d[0] = _mm256_add_pd(d[0], v);
+}
+
+template<int D>
+__attribute__((target("avx2,fma")))
+static void digits_kernel_avx2(const double* a, const double* b, size_t n, const double* sigma, double* d){
+    __m256d s[D], acc[4][D];
+    for (int j = 0; j < D; j++){
+        s[j] = _mm256_set1_pd(sigma[j]);
+        for (int v = 0; v < 4; v++) acc[v][j] = _mm256_setzero_pd();
+    }
+    for (size_t i = 0; i < n; i += SPLIT_LANES){
+        for (int v = 0; v < 4; v++){
+            __m256d x = _mm256_loadu_pd(a + i + 4 * v);
+            __m256d y = _mm256_loadu_pd(b + i + 4 * v);
+            __m256d p = _mm256_mul_pd(x, y);
+            __m256d r = _mm256_fmsub_pd(x, y, p);
+            digits_add_avx2<D>(acc[v], s, p);
+            digits_add_avx2<D>(acc[v], s, r);
+        }
+    }
+    for (int j = 0; j < D; j++){
+        __m256d t = _mm256_add_pd(_mm256_add_pd(acc[0][j], acc[1][j]), _mm256_add_pd(acc[2][j], acc[3][j]));
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, t);
+        d[j] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void scan_kernel_avx512(const double* a, const double* b, size_t n, KeyRange& range){
+    const __m512i abs_mask = _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL);
+    const __m512i big = _mm512_set1_epi64(1 << 20);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i min_key = big, max_key = zero, min_exp = big, max_exp = zero;
+    for (size_t i = 0; i < n; i += 8){
+        __m512i x = _mm512_and_si512(_mm512_loadu_si512(a + i), abs_mask);
+        __m512i y = _mm512_and_si512(_mm512_loadu_si512(b + i), abs_mask);
+        __m512i ex = _mm512_srli_epi64(x, 52), ey = _mm512_srli_epi64(y, 52);
+        __mmask8 nx = _mm512_test_epi64_mask(x, x), ny = _mm512_test_epi64_mask(y, y);
+        __m512i key = _mm512_add_epi64(ex, ey);
+        min_key = _mm512_mask_min_epi64(min_key, nx & ny, min_key, key);
+        max_key = _mm512_mask_max_epi64(max_key, nx & ny, max_key, key);
+        min_exp = _mm512_mask_min_epi64(min_exp, nx, min_exp, ex);
+        min_exp = _mm512_mask_min_epi64(min_exp, ny, min_exp, ey);
+        max_exp = _mm512_max_epi64(max_exp, _mm512_max_epi64(ex, ey));
+    }
+    alignas(64) int64_t v[4][8];
+    _mm512_store_si512(v[0], min_key);
+    _mm512_store_si512(v[1], max_key);
+    _mm512_store_si512(v[2], min_exp);
+    _mm512_store_si512(v[3], max_exp);
+    for (int k = 0; k < 8; k++){
+        KeyRange lane;
+        lane.min_key = v[0][k];
+        lane.max_key = v[1][k];
+        lane.min_exp = v[2][k];
+        lane.max_exp = v[3][k];
+        range.merge(lane);
+    }
+}
+
+template<int D>
+__attribute__((target("avx512f")))
+static inline void digits_add_avx512(__m512d* d, const __m512d* sigma, __m512d v){
+    for (int j = D - 1; j > 0; j--){
+        __m512d q = _mm512_sub_pd(_mm512_add_pd(v, sigma[j]), sigma[j]);
+        d[j] = _mm512_add_pd(d[j], q);
+        v = _mm512_sub_pd(v, q);
+    }
+    d[0] = _mm512_add_pd(d[0], v);
+}
+
+template<int D>
+__attribute__((target("avx512f")))
+static void digits_kernel_avx512(const double* a, const double* b, size_t n, const double* sigma, double* d){
+    __m512d s[D], acc[2][D];
+    for (int j = 0; j < D; j++){
+        s[j] = _mm512_set1_pd(sigma[j]);
+        for (int v = 0; v < 2; v++) acc[v][j] = _mm512_setzero_pd();
+    }
+    for (size_t i = 0; i < n; i += SPLIT_LANES){
+        for (int v = 0; v < 2; v++){
+            __m512d x = _mm512_loadu_pd(a + i + 8 * v);
+            __m512d y = _mm512_loadu_pd(b + i + 8 * v);
+            __m512d p = _mm512_mul_pd(x, y);
+            __m512d r = _mm512_fmsub_pd(x, y, p);
+            digits_add_avx512<D>(acc[v], s, p);
+            digits_add_avx512<D>(acc[v], s, r);
+        }
+    }
+    for (int j = 0; j < D; j++){
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, _mm512_add_pd(acc[0][j], acc[1][j]));
+        d[j] += ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+}
+#endif
+
+// Ядра разрядов по числу разрядов D (от 3 до SPLIT_MAX_DIGITS)
+struct SplitKernels {
+    ScanKernel scan;
+    DigitsKernel digits[SPLIT_MAX_DIGITS + 1];
+};
+
+static SplitKernels select_split_kernels(){
+    SplitKernels k = {scan_kernel_scalar, {nullptr, nullptr, nullptr,
+        digits_kernel_scalar<3>, digits_kernel_scalar<4>, digits_kernel_scalar<5>, digits_kernel_scalar<6>}};
+#ifdef SPLIT_HAVE_X86
+    switch (detect_simd_level()){
+        case SimdLevel::AVX512:
+            k = {scan_kernel_avx512, {nullptr, nullptr, nullptr,
+                digits_kernel_avx512<3>, digits_kernel_avx512<4>, digits_kernel_avx512<5>, digits_kernel_avx512<6>}};
+            break;
+        case SimdLevel::AVX2:
+            k = {scan_kernel_avx2, {nullptr, nullptr, nullptr,
+                digits_kernel_avx2<3>, digits_kernel_avx2<4>, digits_kernel_avx2<5>, digits_kernel_avx2<6>}};
+            break;
+        default:
+            break;
+    }
+#endif
+    return k;
+}
+
+static const SplitKernels& split_kernels(){
+    static const SplitKernels kernels = select_split_kernels();
+    return kernels;
+}
+
+void scan_keys(const double* a, const double* b, size_t n, KeyRange& range){
+    size_t body = n - n % SPLIT_LANES;
+    split_kernels().scan(a, b, body, range);
+    scan_scalar(a, b, body, n, range);
+}
+
+void split_digits(const double* a, const double* b, size_t n, int digits, const double* sigma, double* d){
+    size_t body = n - n % SPLIT_LANES;
+    split_kernels().digits[digits](a, b, body, sigma, d);
+    switch (digits){
+        case 3:  digits_scalar<3>(a, b, body, n, sigma, d); break;
+        case 4:  digits_scalar<4>(a, b, body, n, sigma, d); break;
+        case 5:  digits_scalar<5>(a, b, body, n, sigma, d); break;
+        default: digits_scalar<6>(a, b, body, n, sigma, d); break;
+    }
+}
@@ -0,0 +1,51 @@
+#include "digits.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+double round_digits(int64_t* d, int count, int weight, int scale){
+    normalize_digits(d, count);
+    bool negative = d[count - 1] < 0;
+    if (negative){
+        for (int i = 0; i < count; i++) d[i] = -d[i];
+        normalize_digits(d, count);
+    }
+
+    int top = count - 1;
+    while (top >= 0 && d[top] == 0) top--;
+    if (top < 0) return 0.0;
+
+    // Позиция старшего бита и младшего бита мантиссы результата
+    int high = top * EXACT_DIGIT_BITS + 63 - __builtin_clzll((uint64_t)d[top]);
+    int exp_top = high + weight + scale;
+    if (exp_top < -1075) return negative ? -0.0 : 0.0;  // меньше половины 2^-1074
+    int lsb_exp = max(exp_top - 52, -1074);
+    int low = lsb_exp - scale - weight;
+
+    auto bits_from = [&](int pos) -> uint64_t {         // 64 бита начиная с pos
+        int index = pos / EXACT_DIGIT_BITS;
+        unsigned __int128 w = 0;
+        for (int k = 2; k >= 0; k--){
+            w <<= EXACT_DIGIT_BITS;
+            if (index + k < count) w += (uint64_t)d[index + k];
+        }
+        return (uint64_t)(w >> (pos % EXACT_DIGIT_BITS));
+    };
+
+    // low < 0 — при масштабе вверх все биты суммы помещаются в мантиссу
+    uint64_t mant = low < 0 ? (bits_from(0) & ((2ULL << high) - 1)) << -low
+                            : bits_from(low) & ((1ULL << (high - low + 1)) - 1);
+    bool round_bit = false, sticky = false;
+    if (low > 0){
+        round_bit = (bits_from(low - 1) & 1) != 0;
+        int below = low - 1;                            // биты [0, below)
+        int index = below / EXACT_DIGIT_BITS;
+        if ((uint64_t)d[index] & ((1ULL << (below % EXACT_DIGIT_BITS)) - 1)) sticky = true;
+        for (int i = 0; i < index && !sticky; i++) sticky = d[i] != 0;
+    }
+    if (round_bit && (sticky || (mant & 1))) mant++;   // к ближайшему чётному
+
+    double result = ldexp((double)mant, lsb_exp);
+    return negative ? -result : result;
+}
@@ -0,0 +1,8 @@
+#include "dot_view.hpp"
+
+using namespace std;
+
+DotWorkspace& thread_workspace(){
+    static thread_local DotWorkspace workspace;
+    return workspace;
+}
@@ -0,0 +1,212 @@
+#include "dotk.hpp"
+#include "cpu_dispatch.hpp"
+#include "eft.hpp"
+#include "eft_simd.hpp"
+#include "instrument.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DOTK_HAVE_X86 1
+#endif
+
+using namespace std;
+
+// Состояние цепочки — K уровней с шагом stride: s[k·stride]. Для цепочек
+// ядра stride = DOTK_LANES (уровень k всех цепочек лежит подряд), для
+// одиночной цепочки stride = 1.
+
+// Слагаемое x входит на уровень level; ошибки спускаются ниже
+template<int K>
+static inline void dotk_insert(double* s, size_t stride, double x, int level){
+    for (int k = level; k < K - 1; k++){
+        pair<double, double> t = two_sum(s[k * stride], x);
+        s[k * stride] = t.first;
+        x = t.second;
+    }
+    s[(K - 1) * stride] += x;
+}
+
+// Шаг цепочки: произведение на уровень 0, две потока ошибок (TwoSum и
+// TwoProd) спускаются с уровня 1, на последнем уровне складываются
+template<int K>
+static inline void dotk_update(double* s, size_t stride, double a, double b){
+    pair<double, double> p = exact_multiply(a, b);
+    pair<double, double> t = two_sum(s[0], p.first);
+    s[0] = t.first;
+    double e = t.second, r = p.second;
+    for (int k = 1; k < K - 1; k++){
+        t = two_sum(s[k * stride], e);
+        s[k * stride] = t.first;
+        e = t.second;
+        t = two_sum(s[k * stride], r);
+        s[k * stride] = t.first;
+        r = t.second;
+    }
+    s[(K - 1) * stride] += e + r;
+}
+
+// Округление состояния одной цепочки: K - 1 проходов TwoSum по уровням от
+// младшего к старшему (как SumK над K слагаемыми), затем сумма хвоста
+template<int K>
+static double dotk_finish(const double* s){
+    double v[K];
+    for (int k = 0; k < K; k++) v[k] = s[K - 1 - k];
+    for (int pass = 1; pass < K; pass++){
+        for (int i = 1; i < K; i++){
+            pair<double, double> t = two_sum(v[i], v[i - 1]);
+            v[i] = t.first;
+            v[i - 1] = t.second;
+        }
+    }
+    double tail = 0.0;
+    for (int i = 0; i < K - 1; i++) tail += v[i];
+    return v[K - 1] + tail;
+}
+
+// Элементы [begin, end) по цепочкам i % DOTK_LANES
+template<int K>
+static void dotk_lanes_scalar(DotView a, DotView b, size_t begin, size_t end, double* state){
+    for (size_t i = begin; i < end; i++){
+        dotk_update<K>(state + i % DOTK_LANES, DOTK_LANES, a[i], b[i]);
+    }
+}
+
+// Ядро обрабатывает первые n элементов (n кратно DOTK_LANES)
+typedef void (*DotKKernel)(const double*, const double*, size_t, double*);
+
+template<int K>
+static void dotk_kernel_scalar(const double* a, const double* b, size_t n, double* state){
+    dotk_lanes_scalar<K>(DotView(a, n), DotView(b, n), 0, n, state);
+}
+
+#ifdef DOTK_HAVE_X86
+template<int K>
+__attribute__((target("avx2,fma")))
+static void dotk_kernel_avx2(const double* a, const double* b, size_t n, double* state){
+    __m256d s[K][4];
+    for (int k = 0; k < K; k++){
+        for (int v = 0; v < 4; v++) s[k][v] = _mm256_loadu_pd(state + k * DOTK_LANES + 4 * v);
+    }
+    for (size_t i = 0; i < n; i += DOTK_LANES){
+        for (int v = 0; v < 4; v++){
+            __m256d x = _mm256_loadu_pd(a + i + 4 * v);
+            __m256d y = _mm256_loadu_pd(b + i + 4 * v);
+            __m256d r;
+            __m256d p = two_prod_avx2(x, y, r);
+            __m256d e = two_sum_avx2(s[0][v], p);
+            for (int k = 1; k < K - 1; k++){
+                e = two_sum_avx2(s[k][v], e);
+                r = two_sum_avx2(s[k][v], r);
+            }
+            s[K - 1][v] = _mm256_add_pd(s[K - 1][v], _mm256_add_pd(e, r));
+        }
+    }
+    for (int k = 0; k < K; k++){
+        for (int v = 0; v < 4; v++) _mm256_storeu_pd(state + k * DOTK_LANES + 4 * v, s[k][v]);
+    }
+}
+
+template<int K>
+__attribute__((target("avx512f")))
+static void dotk_kernel_avx512(const double* a, const double* b, size_t n, double* state){
+    __m512d s[K][2];
+    for (int k = 0; k < K; k++){
+        for (int v = 0; v < 2; v++) s[k][v] = _mm512_loadu_pd(state + k * DOTK_LANES + 8 * v);
+    }
+    for (size_t i = 0; i < n; i += DOTK_LANES){
+        for (int v = 0; v < 2; v++){
+            __m512d x = _mm512_loadu_pd(a + i + 8 * v);
+            __m512d y = _mm512_loadu_pd(b + i + 8 * v);
+            __m512d r;
+            __m512d p = two_prod_avx512(x, y, r);
+            __m512d e = two_sum_avx512(s[0][v], p);
+            for (int k = 1; k < K - 1; k++){
+                e = two_sum_avx512(s[k][v], e);
+                r = two_sum_avx512(s[k][v], r);
+            }
+            s[K - 1][v] = _mm512_add_pd(s[K - 1][v], _mm512_add_pd(e, r));
+        }
+    }
+    for (int k = 0; k < K; k++){
+        for (int v = 0; v < 2; v++) _mm512_storeu_pd(state + k * DOTK_LANES + 8 * v, s[k][v]);
+    }
+}
+#endif
+
+template<int K>
+static DotKKernel select_dotk_kernel(){
+#ifdef DOTK_HAVE_X86
+    switch (detect_simd_level()){
+        case SimdLevel::AVX512: return dotk_kernel_avx512<K>;
+        case SimdLevel::AVX2:   return dotk_kernel_avx2<K>;
+        default:                break;
+    }
+#endif
+    return dotk_kernel_scalar<K>;
+}
+
+// Одна последовательная цепочка — на случай переполнения в цепочках
+template<int K>
+static double dotk_serial(DotView a, DotView b){
+    double s[K] = {};
+    for (size_t i = 0; i < a.size; i++) dotk_update<K>(s, 1, a[i], b[i]);
+    return dotk_finish<K>(s);
+}
+
+static const char* const DOTK_NAMES[] = {"DotK 2", "DotK 3", "DotK 4", "DotK 5", "DotK 6", "DotK 7", "DotK 8"};
+
+template<int K>
+double dotk_dot_product(DotView a, DotView b){
+    static_assert(K >= DOTK_MIN && K <= DOTK_MAX, "DotK: K вне [2, 8]");
+    static const DotKKernel kernel = select_dotk_kernel<K>();
+    DOT_INSTRUMENT_CALL(DOTK_NAMES[K - DOTK_MIN], a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+
+    // Непрерывные данные идут в SIMD-ядро, данные с шагом — в скалярные
+    // цепочки с тем же распределением элементов
+    double state[K * DOTK_LANES] = {};
+    size_t n = a.size;
+    size_t body = 0;
+    if (a.contiguous() && b.contiguous()){
+        body = n - n % DOTK_LANES;
+        kernel(a.data, b.data, body, state);
+    }
+    dotk_lanes_scalar<K>(a, b, body, n, state);
+
+    // Цепочки сливаются в одну: уровень k цепочки входит на уровень k
+    DOT_INSTRUMENT_PHASE(Finalize);
+    double total[K] = {};
+    for (size_t lane = 0; lane < DOTK_LANES; lane++){
+        for (int k = 0; k < K; k++) dotk_insert<K>(total, 1, state[k * DOTK_LANES + lane], k);
+    }
+    double result = dotk_finish<K>(total);
+    // Как у Merge: цепочка могла переполниться там, где в общей
+    // последовательности слагаемые взаимно гасятся
+    if (!isfinite(result)) result = dotk_serial<K>(a, b);
+    return DOT_INSTRUMENT_RESULT(result);
+}
+
+template double dotk_dot_product<2>(DotView, DotView);
+template double dotk_dot_product<3>(DotView, DotView);
+template double dotk_dot_product<4>(DotView, DotView);
+template double dotk_dot_product<5>(DotView, DotView);
+template double dotk_dot_product<6>(DotView, DotView);
+template double dotk_dot_product<7>(DotView, DotView);
+template double dotk_dot_product<8>(DotView, DotView);
+
+double dotk_dot_product(DotView a, DotView b, int k){
+    switch (k < DOTK_MIN ? DOTK_MIN : k > DOTK_MAX ? DOTK_MAX : k){
+        case 2:  return dotk_dot_product<2>(a, b);
+        case 3:  return dotk_dot_product<3>(a, b);
+        case 4:  return dotk_dot_product<4>(a, b);
+        case 5:  return dotk_dot_product<5>(a, b);
+        case 6:  return dotk_dot_product<6>(a, b);
+        case 7:  return dotk_dot_product<7>(a, b);
+        default: return dotk_dot_product<8>(a, b);
+    }
+}
+
+double dotk_dot_product(const vector<double>& a, const vector<double>& b, int k){
+    return dotk_dot_product(DotView(a), DotView(b), k);
+}
@@ -0,0 +1,445 @@
+#include "engine.hpp"
+#include "adaptive.hpp"
+#include "batch.hpp"
+#include "fma.hpp"
+#include "kobbelt.hpp"
+#include "long_accumulator.hpp"
+#include "merge.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Состояние разделённой заявки: точные частичные суммы блоков. Exact, как
+// auto_dot_product, сначала идёт проходом Merge с границей погрешности;
+// точный проход по блокам запускается, только если граница не помогла.
+struct SplitState {
+    atomic<size_t> remaining{0};
+    mutex m;
+    LongAccumulator exact;                      // Fma, Exact
+    double error_bound = 0.0;                   // Exact: сумма границ блоков
+    bool exact_pass = false;
+    MergeAccumulator merged;                    // Merge
+    unique_ptr<KobbeltAccumulator> kobbelt;     // Kobbelt (таблица — 32 КБ)
+};
+
+struct EngineRequest {
+    DotView a, b;
+    DotAlgorithm algorithm;
+    promise<double> result;                     // если нет callback
+    function<void(double)> callback;
+    unique_ptr<SplitState> split;
+
+    EngineRequest(DotView a, DotView b, DotAlgorithm algorithm)
+        : a(a), b(b), algorithm(algorithm) {}
+};
+
+// Ограниченная очередь MPMC без блокировок (Вьюков): в каждой ячейке —
+// номер поколения. Ячейка свободна для записи на позиции pos, если её
+// номер равен pos, и готова к чтению, если равен pos + 1.
+class SubmissionQueue {
+public:
+    SubmissionQueue() : cells(new Cell[ENGINE_QUEUE_SIZE]){
+        for (size_t i = 0; i < ENGINE_QUEUE_SIZE; i++) cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    bool push(EngineRequest* request){
+        size_t pos = enqueue_pos.load(memory_order_relaxed);
+        for (;;){
+            Cell& cell = cells[pos & (ENGINE_QUEUE_SIZE - 1)];
+            size_t seq = cell.sequence.load(memory_order_acquire);
+            if (seq == pos){
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                    cell.request = request;
+                    cell.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos){
+                return false;                   // очередь полна
+            } else {
+                pos = enqueue_pos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(EngineRequest*& request){
+        size_t pos = dequeue_pos.load(memory_order_relaxed);
+        for (;;){
+            Cell& cell = cells[pos & (ENGINE_QUEUE_SIZE - 1)];
+            size_t seq = cell.sequence.load(memory_order_acquire);
+            if (seq == pos + 1){
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                    request = cell.request;
+                    cell.sequence.store(pos + ENGINE_QUEUE_SIZE, memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos + 1){
+                return false;                   // очередь пуста
+            } else {
+                pos = dequeue_pos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Приблизительно: заявка могла быть занята, но ещё не записана
+    bool empty() const {
+        return enqueue_pos.load(memory_order_seq_cst) == dequeue_pos.load(memory_order_seq_cst);
+    }
+
+private:
+    struct Cell {
+        atomic<size_t> sequence;
+        EngineRequest* request;
+    };
+    unique_ptr<Cell[]> cells;
+    alignas(64) atomic<size_t> enqueue_pos{0};
+    alignas(64) atomic<size_t> dequeue_pos{0};
+};
+
+// Блок разделённой заявки
+struct ChunkTask {
+    EngineRequest* request;
+    size_t chunk;
+};
+
+// Дека блоков одного потока: владелец берёт с конца (последний положенный
+// блок ещё в кэше), воры — с начала. Блоки крупные (PARALLEL_BLOCK
+// элементов), поэтому короткая блокировка на операцию не заметна.
+struct WorkerDeque {
+    mutex m;
+    deque<ChunkTask> tasks;
+};
+
+struct DotEngine::Shared {
+    SubmissionQueue queue;
+    vector<unique_ptr<WorkerDeque>> deques;
+    vector<thread> workers;
+    atomic<size_t> queued_chunks{0};
+
+    // Сон без работы: счётчик спящих проверяется после публикации заявки,
+    // будить через мьютекс нужно только если кто-то спит
+    mutex sleep_mutex;
+    condition_variable wake;
+    atomic<size_t> sleepers{0};
+    bool stop = false;
+
+    atomic<uint64_t> submitted{0}, completed{0}, coalesced{0}, split{0}, stolen{0};
+
+    void enqueue(EngineRequest* request);
+    void worker_loop(size_t id);
+    bool has_work() const { return !queue.empty() || queued_chunks.load() != 0; }
+    void notify(size_t count);
+
+    void take_from_queue(size_t id, EngineRequest* first);
+    void run_whole(EngineRequest* request);
+    void run_coalesced(EngineRequest** batch, size_t count);
+    void start_split(size_t id, EngineRequest* request);
+    void push_chunks(size_t id, EngineRequest* request);
+    void run_chunk(size_t id, const ChunkTask& task);
+    bool pop_own(size_t id, ChunkTask& task);
+    bool steal(size_t id, ChunkTask& task);
+    void finish(EngineRequest* request, double result);
+};
+
+void DotEngine::Shared::notify(size_t count){
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleepers.load() == 0) return;
+    lock_guard<mutex> lock(sleep_mutex);
+    if (count == 1) wake.notify_one();
+    else wake.notify_all();
+}
+
+void DotEngine::Shared::finish(EngineRequest* request, double result){
+    if (request->callback) request->callback(result);
+    else request->result.set_value(result);
+    delete request;
+    completed++;
+}
+
+static bool is_split(const EngineRequest* request){
+    return request->a.size >= ENGINE_SPLIT;
+}
+
+void DotEngine::Shared::run_whole(EngineRequest* request){
+    DotView a = request->a, b = request->b;
+    double result = 0.0;
+    switch (request->algorithm){
+        case DotAlgorithm::Fma:     result = fma_dot_product(a, b); break;
+        case DotAlgorithm::Merge:   result = merge_dot_product(a, b); break;
+        case DotAlgorithm::Kobbelt: result = kobbelt_dot_product(a, b); break;
+        case DotAlgorithm::Exact:   result = auto_dot_product(a, b); break;
+    }
+    finish(request, result);
+}
+
+// Пачка коротких заявок: одинаковые (алгоритм, длина) с непрерывными
+// операндами считаются пакетным ядром, остальные — по одной
+void DotEngine::Shared::run_coalesced(EngineRequest** batch, size_t count){
+    auto batchable = [](const EngineRequest* r){
+        return (r->algorithm == DotAlgorithm::Fma || r->algorithm == DotAlgorithm::Merge)
+            && r->a.contiguous() && r->b.contiguous();
+    };
+    stable_sort(batch, batch + count, [&](const EngineRequest* x, const EngineRequest* y){
+        bool bx = batchable(x), by = batchable(y);
+        if (bx != by) return bx;
+        if (x->algorithm != y->algorithm) return x->algorithm < y->algorithm;
+        return x->a.size < y->a.size;
+    });
+
+    DotPair pairs[ENGINE_COALESCE];
+    double out[ENGINE_COALESCE];
+    size_t begin = 0;
+    while (begin < count){
+        EngineRequest* head = batch[begin];
+        size_t end = begin + 1;
+        if (batchable(head)){
+            while (end < count && batchable(batch[end]) && batch[end]->algorithm == head->algorithm
+                   && batch[end]->a.size == head->a.size) end++;
+        }
+        size_t group = end - begin;
+        if (group == 1){
+            run_whole(head);
+        } else {
+            for (size_t k = 0; k < group; k++) pairs[k] = {batch[begin + k]->a.data, batch[begin + k]->b.data};
+            if (head->algorithm == DotAlgorithm::Fma) fma_dot_product_batch(pairs, group, head->a.size, out);
+            else merge_dot_product_batch(pairs, group, head->a.size, out);
+            coalesced += group;
+            for (size_t k = 0; k < group; k++) finish(batch[begin + k], out[k]);
+        }
+        begin = end;
+    }
+}
+
+void DotEngine::Shared::start_split(size_t id, EngineRequest* request){
+    request->split.reset(new SplitState);
+    if (request->algorithm == DotAlgorithm::Kobbelt) request->split->kobbelt.reset(new KobbeltAccumulator);
+    split++;
+    push_chunks(id, request);
+}
+
+// Блоки 1..k-1 ложатся в свою деку (их разберут воры), блок 0 — сразу
+void DotEngine::Shared::push_chunks(size_t id, EngineRequest* request){
+    size_t chunks = (request->a.size + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+    request->split->remaining.store(chunks);
+    queued_chunks += chunks - 1;
+    {
+        lock_guard<mutex> lock(deques[id]->m);
+        for (size_t k = chunks; k-- > 1;) deques[id]->tasks.push_back({request, k});
+    }
+    notify(chunks - 1);
+    run_chunk(id, {request, 0});
+}
+
+// Граница S ± bound вокруг точной суммы S блоков Merge: если оба конца
+// округляются в одно конечное число, в него же округляется и точное значение
+static bool certified_round_sum(const LongAccumulator& sum, double bound, double& result){
+    if (!isfinite(bound)) return false;
+    LongAccumulator low = sum, high = sum;
+    low.add(-bound);
+    high.add(bound);
+    double r = low.round();
+    if (!isfinite(r) || high.round() != r) return false;
+    result = r;
+    return true;
+}
+
+void DotEngine::Shared::run_chunk(size_t id, const ChunkTask& task){
+    EngineRequest* request = task.request;
+    SplitState& state = *request->split;
+    size_t begin = task.chunk * PARALLEL_BLOCK;
+    size_t count = min(request->a.size - begin, PARALLEL_BLOCK);
+    DotView a = request->a.slice(begin, count), b = request->b.slice(begin, count);
+
+    // Частичные суммы складываются точно — порядок блоков не важен
+    switch (request->algorithm){
+        case DotAlgorithm::Fma: {
+            double partial = fma_dot_product(a, b);
+            lock_guard<mutex> lock(state.m);
+            state.exact.add(partial);
+            break;
+        }
+        case DotAlgorithm::Merge: {
+            MergeAccumulator partial;
+            partial.add(a, b);
+            lock_guard<mutex> lock(state.m);
+            state.merged.merge(partial);
+            break;
+        }
+        case DotAlgorithm::Kobbelt: {
+            unique_ptr<KobbeltAccumulator> partial(new KobbeltAccumulator);
+            partial->add(a, b);
+            lock_guard<mutex> lock(state.m);
+            state.kobbelt->merge(*partial);
+            break;
+        }
+        case DotAlgorithm::Exact: {
+            if (state.exact_pass){
+                LongAccumulator partial;
+                partial.add(a, b);
+                lock_guard<mutex> lock(state.m);
+                state.exact.merge(partial);
+            } else {
+                double abs_sum;
+                DoubleDouble partial = merge_dot_product_bounded(a, b, abs_sum);
+                double bound = dot2_error_bound(count, abs_sum);
+                lock_guard<mutex> lock(state.m);
+                state.exact.add(partial.hi);
+                state.exact.add(partial.lo);
+                state.error_bound += bound;
+            }
+            break;
+        }
+    }
+    if (state.remaining.fetch_sub(1) != 1) return;
+
+    double result = 0.0;
+    switch (request->algorithm){
+        case DotAlgorithm::Merge:   result = state.merged.finalize(); break;
+        case DotAlgorithm::Kobbelt: result = state.kobbelt->finalize(); break;
+        case DotAlgorithm::Fma:     result = state.exact.round(); break;
+        case DotAlgorithm::Exact: {
+            // Сумма k границ блоков занижена не больше чем в (1 + k·u)
+            size_t chunks = (request->a.size + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+            double bound = state.error_bound * (1.0 + (double)chunks * 0x1p-52);
+            if (state.exact_pass || !certified_round_sum(state.exact, bound, result)){
+                if (!state.exact_pass){
+                    state.exact_pass = true;
+                    state.exact = LongAccumulator();
+                    push_chunks(id, request);
+                    return;
+                }
+                result = state.exact.round();
+            }
+            break;
+        }
+    }
+    finish(request, result);
+}
+
+bool DotEngine::Shared::pop_own(size_t id, ChunkTask& task){
+    WorkerDeque& own = *deques[id];
+    lock_guard<mutex> lock(own.m);
+    if (own.tasks.empty()) return false;
+    task = own.tasks.back();
+    own.tasks.pop_back();
+    queued_chunks--;
+    return true;
+}
+
+bool DotEngine::Shared::steal(size_t id, ChunkTask& task){
+    for (size_t k = 1; k < deques.size(); k++){
+        WorkerDeque& victim = *deques[(id + k) % deques.size()];
+        lock_guard<mutex> lock(victim.m);
+        if (victim.tasks.empty()) continue;
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        queued_chunks--;
+        stolen++;
+        return true;
+    }
+    return false;
+}
+
+// Первая заявка уже взята. Короткие добираются из очереди до пачки;
+// первая же длинная заканчивает набор и считается после пачки.
+void DotEngine::Shared::take_from_queue(size_t id, EngineRequest* first){
+    if (first->a.size > ENGINE_SMALL){
+        if (is_split(first)) start_split(id, first);
+        else run_whole(first);
+        return;
+    }
+    EngineRequest* batch[ENGINE_COALESCE];
+    size_t count = 0;
+    EngineRequest* rest = nullptr;
+    batch[count++] = first;
+    EngineRequest* next;
+    while (count < ENGINE_COALESCE && queue.pop(next)){
+        if (next->a.size > ENGINE_SMALL){
+            rest = next;
+            break;
+        }
+        batch[count++] = next;
+    }
+    run_coalesced(batch, count);
+    if (rest) take_from_queue(id, rest);
+}
+
+void DotEngine::Shared::worker_loop(size_t id){
+    const int SPINS = 64;
+    int idle = 0;
+    for (;;){
+        // Сначала свои блоки и чужие блоки: разделённая заявка держит
+        // ожидающего дольше всех
+        ChunkTask task;
+        EngineRequest* request;
+        if (pop_own(id, task) || steal(id, task)){
+            run_chunk(id, task);
+            idle = 0;
+        } else if (queue.pop(request)){
+            take_from_queue(id, request);
+            idle = 0;
+        } else if (++idle < SPINS){
+            this_thread::yield();
+        } else {
+            unique_lock<mutex> lock(sleep_mutex);
+            sleepers++;
+            atomic_thread_fence(memory_order_seq_cst);
+            while (!stop && !has_work()) wake.wait(lock);
+            sleepers--;
+            // Остановка — только когда все принятые заявки посчитаны
+            if (stop && !has_work()) return;
+            idle = 0;
+        }
+    }
+}
+
+DotEngine::DotEngine(size_t threads) : shared(new Shared){
+    if (threads == 0) threads = default_thread_count();
+    for (size_t id = 0; id < threads; id++) shared->deques.emplace_back(new WorkerDeque);
+    for (size_t id = 0; id < threads; id++){
+        shared->workers.emplace_back([this, id]{ shared->worker_loop(id); });
+    }
+}
+
+DotEngine::~DotEngine(){
+    {
+        lock_guard<mutex> lock(shared->sleep_mutex);
+        shared->stop = true;
+    }
+    shared->wake.notify_all();
+    for (auto& w : shared->workers) w.join();
+}
+
+// Полная очередь — подпор: отправитель уступает процессор рабочим
+void DotEngine::Shared::enqueue(EngineRequest* request){
+    submitted++;
+    while (!queue.push(request)) this_thread::yield();
+    notify(1);
+}
+
+future<double> DotEngine::submit(DotView a, DotView b, DotAlgorithm algorithm){
+    EngineRequest* request = new EngineRequest(a, b, algorithm);
+    future<double> result = request->result.get_future();
+    shared->enqueue(request);
+    return result;
+}
+
+void DotEngine::submit(DotView a, DotView b, DotAlgorithm algorithm, function<void(double)> callback){
+    EngineRequest* request = new EngineRequest(a, b, algorithm);
+    request->callback = move(callback);
+    shared->enqueue(request);
+}
+
+size_t DotEngine::threads() const {
+    return shared->workers.size();
+}
+
+DotEngineStats DotEngine::stats() const {
+    return {shared->submitted.load(), shared->completed.load(), shared->coalesced.load(),
+            shared->split.load(), shared->stolen.load()};
+}
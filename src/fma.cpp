@@ -1,4 +1,5 @@
 #include "fma.hpp"
+#include "instrument.hpp"
 #include <cmath>
 #include <cstdint>
 #include <vector>
@@ -6,13 +7,18 @@
 
 using namespace std;
 
-double fma_dot_product(const vector<double>& a, const vector<double>& b){
-    vector<double> table;
+double fma_dot_product(DotView a, DotView b){
+    DOT_INSTRUMENT_CALL("FMA", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
     double fma_sum = 0.0;
     
-    for (int i = 0; i < a.size(); i++){
+    for (size_t i = 0; i < a.size; i++){
         fma_sum = fma(a[i], b[i], fma_sum);
     }
 
-    return fma_sum; 
-}
\ No newline at end of file
+    return DOT_INSTRUMENT_RESULT(fma_sum);
+}
+
+double fma_dot_product(const vector<double>& a, const vector<double>& b){
+    return fma_dot_product(DotView(a), DotView(b));
+}
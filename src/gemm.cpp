@@ -0,0 +1,504 @@
+#include "gemm.hpp"
+#include "adaptive.hpp"
+#include "cpu_dispatch.hpp"
+#include "eft.hpp"
+#include "eft_simd.hpp"
+#include "long_accumulator.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GEMM_HAVE_X86 1
+#endif
+
+using namespace std;
+
+// Микроядро: блок MR × NRW элементов C. ap — упакованная панель A
+// (kc строк по MR чисел), bp — упакованная панель B (kc строк по NRW
+// чисел). Состояние цепочек hi, lo (и с TrackAbs — sum |a·b|) лежит в
+// буферах блока с шагом строк ld и продолжается между порциями по k.
+typedef void (*GemmKernel)(const double* ap, const double* bp, size_t kc,
+                           double* hi, double* lo, double* abs_sum, size_t ld);
+
+// Скалярное ядро — ровно dot2_update из eft.hpp; векторные ядра повторяют
+// ту же последовательность операций поэлементно
+template<int MR, int NRW, bool TrackAbs>
+static void gemm_kernel_scalar(const double* ap, const double* bp, size_t kc,
+                               double* hi, double* lo, double* abs_sum, size_t ld){
+    double h[MR][NRW], l[MR][NRW], m[MR][NRW];
+    for (int r = 0; r < MR; r++){
+        for (int j = 0; j < NRW; j++){
+            h[r][j] = hi[r * ld + j];
+            l[r][j] = lo[r * ld + j];
+            if (TrackAbs) m[r][j] = abs_sum[r * ld + j];
+        }
+    }
+    for (size_t k = 0; k < kc; k++){
+        for (int r = 0; r < MR; r++){
+            double x = ap[k * MR + r];
+            for (int j = 0; j < NRW; j++){
+                double y = bp[k * NRW + j];
+                dot2_update(h[r][j], l[r][j], x, y);
+                if (TrackAbs) m[r][j] += fabs(x * y);
+            }
+        }
+    }
+    for (int r = 0; r < MR; r++){
+        for (int j = 0; j < NRW; j++){
+            hi[r * ld + j] = h[r][j];
+            lo[r * ld + j] = l[r][j];
+            if (TrackAbs) abs_sum[r * ld + j] = m[r][j];
+        }
+    }
+}
+
+#ifdef GEMM_HAVE_X86
+// Разряды вектора — соседние столбцы C; элемент A размножается на вектор
+template<int MR, int NV, bool TrackAbs>
+__attribute__((target("avx2,fma")))
+static void gemm_kernel_avx2(const double* ap, const double* bp, size_t kc,
+                             double* hi, double* lo, double* abs_sum, size_t ld){
+    const int NRW = 4 * NV;
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d h[MR][NV], l[MR][NV], m[MR][NV];
+    for (int r = 0; r < MR; r++){
+        for (int v = 0; v < NV; v++){
+            h[r][v] = _mm256_loadu_pd(hi + r * ld + 4 * v);
+            l[r][v] = _mm256_loadu_pd(lo + r * ld + 4 * v);
+            if (TrackAbs) m[r][v] = _mm256_loadu_pd(abs_sum + r * ld + 4 * v);
+        }
+    }
+    for (size_t k = 0; k < kc; k++){
+        __m256d y[NV];
+        for (int v = 0; v < NV; v++) y[v] = _mm256_loadu_pd(bp + k * NRW + 4 * v);
+        for (int r = 0; r < MR; r++){
+            __m256d x = _mm256_broadcast_sd(ap + k * MR + r);
+            for (int v = 0; v < NV; v++){
+                __m256d p = dot2_step_avx2(h[r][v], l[r][v], x, y[v]);
+                if (TrackAbs) m[r][v] = _mm256_add_pd(m[r][v], _mm256_andnot_pd(sign, p));
+            }
+        }
+    }
+    for (int r = 0; r < MR; r++){
+        for (int v = 0; v < NV; v++){
+            _mm256_storeu_pd(hi + r * ld + 4 * v, h[r][v]);
+            _mm256_storeu_pd(lo + r * ld + 4 * v, l[r][v]);
+            if (TrackAbs) _mm256_storeu_pd(abs_sum + r * ld + 4 * v, m[r][v]);
+        }
+    }
+}
+
+template<int MR, int NV, bool TrackAbs>
+__attribute__((target("avx512f")))
+static void gemm_kernel_avx512(const double* ap, const double* bp, size_t kc,
+                               double* hi, double* lo, double* abs_sum, size_t ld){
+    const int NRW = 8 * NV;
+    __m512d h[MR][NV], l[MR][NV], m[MR][NV];
+    for (int r = 0; r < MR; r++){
+        for (int v = 0; v < NV; v++){
+            h[r][v] = _mm512_loadu_pd(hi + r * ld + 8 * v);
+            l[r][v] = _mm512_loadu_pd(lo + r * ld + 8 * v);
+            if (TrackAbs) m[r][v] = _mm512_loadu_pd(abs_sum + r * ld + 8 * v);
+        }
+    }
+    for (size_t k = 0; k < kc; k++){
+        __m512d y[NV];
+        for (int v = 0; v < NV; v++) y[v] = _mm512_loadu_pd(bp + k * NRW + 8 * v);
+        for (int r = 0; r < MR; r++){
+            __m512d x = _mm512_set1_pd(ap[k * MR + r]);
+            for (int v = 0; v < NV; v++){
+                __m512d p = dot2_step_avx512(h[r][v], l[r][v], x, y[v]);
+                if (TrackAbs) m[r][v] = _mm512_add_pd(m[r][v], _mm512_abs_pd(p));
+            }
+        }
+    }
+    for (int r = 0; r < MR; r++){
+        for (int v = 0; v < NV; v++){
+            _mm512_storeu_pd(hi + r * ld + 8 * v, h[r][v]);
+            _mm512_storeu_pd(lo + r * ld + 8 * v, l[r][v]);
+            if (TrackAbs) _mm512_storeu_pd(abs_sum + r * ld + 8 * v, m[r][v]);
+        }
+    }
+}
+#endif
+
+// GEMV без упаковки: ядро ведёт R подряд идущих строк A по n столбцам.
+// Строка — отдельная цепочка Dot2 по k по возрастанию, как элемент gemm;
+// x[k] читается один раз на все R строк. Состояние hi, lo (и с TrackAbs —
+// sum |a·x|) лежит в hi[0..R), lo[0..R) и продолжается между порциями по k.
+typedef void (*GemvKernel)(const double* a, ptrdiff_t row_stride, ptrdiff_t col_stride,
+                           const double* x, ptrdiff_t x_stride, size_t n,
+                           double* hi, double* lo, double* abs_sum);
+
+template<int R, bool TrackAbs>
+static void gemv_kernel_scalar(const double* a, ptrdiff_t row_stride, ptrdiff_t col_stride,
+                               const double* x, ptrdiff_t x_stride, size_t n,
+                               double* hi, double* lo, double* abs_sum){
+    double h[R], l[R], m[R];
+    for (int r = 0; r < R; r++){
+        h[r] = hi[r];
+        l[r] = lo[r];
+        if (TrackAbs) m[r] = abs_sum[r];
+    }
+    for (size_t k = 0; k < n; k++){
+        double y = x[(ptrdiff_t)k * x_stride];
+        for (int r = 0; r < R; r++){
+            double v = a[(ptrdiff_t)r * row_stride + (ptrdiff_t)k * col_stride];
+            dot2_update(h[r], l[r], v, y);
+            if (TrackAbs) m[r] += fabs(v * y);
+        }
+    }
+    for (int r = 0; r < R; r++){
+        hi[r] = h[r];
+        lo[r] = l[r];
+        if (TrackAbs) abs_sum[r] = m[r];
+    }
+}
+
+#ifdef GEMM_HAVE_X86
+// Разряд вектора — строка. A по строкам (шаг столбцов 1) читается блоками
+// L × L с транспонированием в регистрах, по столбцам (шаг строк 1) — прямо
+// отрезком столбца; при других шагах и на хвосте k разряды собираются
+// поэлементно.
+
+// col[j] — элементы k + j четырёх строк a, a + stride, …
+__attribute__((target("avx2,fma")))
+static inline void load_transposed_avx2(const double* a, ptrdiff_t stride, __m256d* col){
+    __m256d r0 = _mm256_loadu_pd(a);
+    __m256d r1 = _mm256_loadu_pd(a + stride);
+    __m256d r2 = _mm256_loadu_pd(a + 2 * stride);
+    __m256d r3 = _mm256_loadu_pd(a + 3 * stride);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    col[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+    col[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+    col[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+    col[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256d load_lanes_avx2(const double* a, ptrdiff_t stride){
+    return _mm256_set_pd(a[3 * stride], a[2 * stride], a[stride], a[0]);
+}
+
+template<bool TrackAbs>
+__attribute__((target("avx2,fma")))
+static inline void gemv_step_avx2(__m256d& h, __m256d& l, __m256d& m, __m256d col, __m256d y){
+    __m256d p = dot2_step_avx2(h, l, col, y);
+    if (TrackAbs) m = _mm256_add_pd(m, _mm256_andnot_pd(_mm256_set1_pd(-0.0), p));
+}
+
+template<int NV, bool TrackAbs>
+__attribute__((target("avx2,fma")))
+static void gemv_kernel_avx2(const double* a, ptrdiff_t row_stride, ptrdiff_t col_stride,
+                             const double* x, ptrdiff_t x_stride, size_t n,
+                             double* hi, double* lo, double* abs_sum){
+    __m256d h[NV], l[NV], m[NV];
+    for (int v = 0; v < NV; v++){
+        h[v] = _mm256_loadu_pd(hi + 4 * v);
+        l[v] = _mm256_loadu_pd(lo + 4 * v);
+        if (TrackAbs) m[v] = _mm256_loadu_pd(abs_sum + 4 * v);
+    }
+    size_t k = 0;
+    if (col_stride == 1){
+        for (; k + 4 <= n; k += 4){
+            __m256d col[NV][4];
+            for (int v = 0; v < NV; v++) load_transposed_avx2(a + 4 * v * row_stride + k, row_stride, col[v]);
+            for (int j = 0; j < 4; j++){
+                __m256d y = _mm256_set1_pd(x[(ptrdiff_t)(k + j) * x_stride]);
+                for (int v = 0; v < NV; v++) gemv_step_avx2<TrackAbs>(h[v], l[v], m[v], col[v][j], y);
+            }
+        }
+    } else if (row_stride == 1){
+        for (; k < n; k++){
+            __m256d y = _mm256_set1_pd(x[(ptrdiff_t)k * x_stride]);
+            for (int v = 0; v < NV; v++){
+                gemv_step_avx2<TrackAbs>(h[v], l[v], m[v], _mm256_loadu_pd(a + (ptrdiff_t)k * col_stride + 4 * v), y);
+            }
+        }
+    }
+    for (; k < n; k++){
+        __m256d y = _mm256_set1_pd(x[(ptrdiff_t)k * x_stride]);
+        for (int v = 0; v < NV; v++){
+            __m256d col = load_lanes_avx2(a + 4 * v * row_stride + (ptrdiff_t)k * col_stride, row_stride);
+            gemv_step_avx2<TrackAbs>(h[v], l[v], m[v], col, y);
+        }
+    }
+    for (int v = 0; v < NV; v++){
+        _mm256_storeu_pd(hi + 4 * v, h[v]);
+        _mm256_storeu_pd(lo + 4 * v, l[v]);
+        if (TrackAbs) _mm256_storeu_pd(abs_sum + 4 * v, m[v]);
+    }
+}
+
+// То же для восьми строк: пары строк, затем 128-битные четверти
+__attribute__((target("avx512f")))
+static inline void load_transposed_avx512(const double* a, ptrdiff_t stride, __m512d* col){
+    __m512d r[8], t[8], u[8];
+    for (int i = 0; i < 8; i++) r[i] = _mm512_loadu_pd(a + i * stride);
+    for (int i = 0; i < 8; i += 2){
+        t[i] = _mm512_unpacklo_pd(r[i], r[i + 1]);          // элементы 0, 2, 4, 6
+        t[i + 1] = _mm512_unpackhi_pd(r[i], r[i + 1]);      // элементы 1, 3, 5, 7
+    }
+    for (int i = 0; i < 8; i += 4){
+        for (int odd = 0; odd < 2; odd++){
+            u[i + odd] = _mm512_shuffle_f64x2(t[i + odd], t[i + 2 + odd], 0x88);      // 0, 4 (1, 5)
+            u[i + 2 + odd] = _mm512_shuffle_f64x2(t[i + odd], t[i + 2 + odd], 0xDD);  // 2, 6 (3, 7)
+        }
+    }
+    for (int j = 0; j < 4; j++){
+        int first = (j & 1) + (j >> 1) * 2;                  // u[j] несёт элементы first и first + 4
+        col[first] = _mm512_shuffle_f64x2(u[j], u[j + 4], 0x88);
+        col[first + 4] = _mm512_shuffle_f64x2(u[j], u[j + 4], 0xDD);
+    }
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d load_lanes_avx512(const double* a, ptrdiff_t stride){
+    return _mm512_set_pd(a[7 * stride], a[6 * stride], a[5 * stride], a[4 * stride],
+                         a[3 * stride], a[2 * stride], a[stride], a[0]);
+}
+
+template<bool TrackAbs>
+__attribute__((target("avx512f")))
+static inline void gemv_step_avx512(__m512d& h, __m512d& l, __m512d& m, __m512d col, __m512d y){
+    __m512d p = dot2_step_avx512(h, l, col, y);
+    if (TrackAbs) m = _mm512_add_pd(m, _mm512_abs_pd(p));
+}
+
+template<int NV, bool TrackAbs>
+__attribute__((target("avx512f")))
+static void gemv_kernel_avx512(const double* a, ptrdiff_t row_stride, ptrdiff_t col_stride,
+                               const double* x, ptrdiff_t x_stride, size_t n,
+                               double* hi, double* lo, double* abs_sum){
+    __m512d h[NV], l[NV], m[NV];
+    for (int v = 0; v < NV; v++){
+        h[v] = _mm512_loadu_pd(hi + 8 * v);
+        l[v] = _mm512_loadu_pd(lo + 8 * v);
+        if (TrackAbs) m[v] = _mm512_loadu_pd(abs_sum + 8 * v);
+    }
+    size_t k = 0;
+    if (col_stride == 1){
+        for (; k + 8 <= n; k += 8){
+            __m512d col[NV][8];
+            for (int v = 0; v < NV; v++) load_transposed_avx512(a + 8 * v * row_stride + k, row_stride, col[v]);
+            for (int j = 0; j < 8; j++){
+                __m512d y = _mm512_set1_pd(x[(ptrdiff_t)(k + j) * x_stride]);
+                for (int v = 0; v < NV; v++) gemv_step_avx512<TrackAbs>(h[v], l[v], m[v], col[v][j], y);
+            }
+        }
+    } else if (row_stride == 1){
+        for (; k < n; k++){
+            __m512d y = _mm512_set1_pd(x[(ptrdiff_t)k * x_stride]);
+            for (int v = 0; v < NV; v++){
+                gemv_step_avx512<TrackAbs>(h[v], l[v], m[v], _mm512_loadu_pd(a + (ptrdiff_t)k * col_stride + 8 * v), y);
+            }
+        }
+    }
+    for (; k < n; k++){
+        __m512d y = _mm512_set1_pd(x[(ptrdiff_t)k * x_stride]);
+        for (int v = 0; v < NV; v++){
+            __m512d col = load_lanes_avx512(a + 8 * v * row_stride + (ptrdiff_t)k * col_stride, row_stride);
+            gemv_step_avx512<TrackAbs>(h[v], l[v], m[v], col, y);
+        }
+    }
+    for (int v = 0; v < NV; v++){
+        _mm512_storeu_pd(hi + 8 * v, h[v]);
+        _mm512_storeu_pd(lo + 8 * v, l[v]);
+        if (TrackAbs) _mm512_storeu_pd(abs_sum + 8 * v, m[v]);
+    }
+}
+#endif
+
+// Форма разбиения GEMM: микроблок mr × nrw, блок кэша mc × nc, порция k
+// длины kc
+struct GemmShape {
+    size_t mr, nrw;
+    size_t mc, nc, kc;
+    GemmKernel kernel[2];                       // [TrackAbs]
+};
+
+// GEMV: строк на одно ядро
+struct GemvShape {
+    size_t rows;
+    GemvKernel kernel[2];                       // [TrackAbs]
+};
+
+struct GemmShapes {
+    GemmShape matrix;
+    GemvShape vector;
+};
+
+static GemmShapes select_shapes(){
+    const size_t MC = 32, NC = 128, KC = 256;
+#ifdef GEMM_HAVE_X86
+    switch (detect_simd_level()){
+        case SimdLevel::AVX512:
+            return {{4, 16, MC, NC, KC, {gemm_kernel_avx512<4, 2, false>, gemm_kernel_avx512<4, 2, true>}},
+                    {16, {gemv_kernel_avx512<2, false>, gemv_kernel_avx512<2, true>}}};
+        case SimdLevel::AVX2:
+            return {{4, 8, MC, NC, KC, {gemm_kernel_avx2<4, 2, false>, gemm_kernel_avx2<4, 2, true>}},
+                    {8, {gemv_kernel_avx2<2, false>, gemv_kernel_avx2<2, true>}}};
+        default:
+            break;
+    }
+#endif
+    return {{4, 8, MC, NC, KC, {gemm_kernel_scalar<4, 8, false>, gemm_kernel_scalar<4, 8, true>}},
+            {4, {gemv_kernel_scalar<4, false>, gemv_kernel_scalar<4, true>}}};
+}
+
+static const GemmShapes& gemm_shapes(){
+    static const GemmShapes shapes = select_shapes();
+    return shapes;
+}
+
+// Упаковка панели: dst[(p·rows + k)·width + j] = src(k, p·width + j), нули
+// за границей. Если источник плотнее по j, строка k читается целиком сразу
+// во все панели; если по k — переставляем полосами по 8 столбцов, чтобы
+// чтение шло восемью последовательными потоками, а запись — строками кэша.
+static void pack_panels(double* dst, size_t rows, size_t cols, size_t width,
+                        const double* src, ptrdiff_t k_stride, ptrdiff_t j_stride){
+    size_t panels = (cols + width - 1) / width;
+    if (abs(j_stride) <= abs(k_stride)){
+        for (size_t k = 0; k < rows; k++){
+            const double* s = src + (ptrdiff_t)k * k_stride;
+            for (size_t p = 0; p < panels; p++){
+                double* row = dst + (p * rows + k) * width;
+                size_t count = min(width, cols - p * width);
+                const double* sp = s + (ptrdiff_t)(p * width) * j_stride;
+                if (j_stride == 1) memcpy(row, sp, count * sizeof(double));
+                else for (size_t j = 0; j < count; j++) row[j] = sp[(ptrdiff_t)j * j_stride];
+            }
+        }
+    } else {
+        const size_t strip = min<size_t>(8, width);            // ширины — степени двойки
+        for (size_t j0 = 0; j0 < cols; j0 += strip){
+            size_t count = min(strip, cols - j0);
+            double* panel = dst + j0 / width * rows * width + j0 % width;
+            const double* s = src + (ptrdiff_t)j0 * j_stride;
+            for (size_t k = 0; k < rows; k++){
+                const double* sk = s + (ptrdiff_t)k * k_stride;
+                for (size_t j = 0; j < count; j++) panel[k * width + j] = sk[(ptrdiff_t)j * j_stride];
+            }
+        }
+    }
+    size_t tail = panels * width - cols;
+    if (tail){
+        double* panel = dst + (panels - 1) * rows * width;
+        for (size_t k = 0; k < rows; k++){
+            for (size_t j = width - tail; j < width; j++) panel[k * width + j] = 0.0;
+        }
+    }
+}
+
+// Блок C[i0 .. i0 + mc) × [j0 .. j0 + nc): полный проход по k порциями kc.
+// Порядок k в каждой цепочке — по возрастанию, поэтому результат не
+// зависит от разбиения на блоки и потоки.
+static void gemm_block(const GemmShape& shape, MatrixView a, MatrixView b, size_t i0, size_t mc,
+                       size_t j0, size_t nc, double* c, ptrdiff_t c_row, ptrdiff_t c_col, GemmMode mode){
+    static thread_local vector<double> apack, bpack, hi, lo, abs_sum;
+    const bool exact = mode == GemmMode::Exact;
+    const size_t k_total = a.cols;
+    size_t row_panels = (mc + shape.mr - 1) / shape.mr;
+    size_t col_panels = (nc + shape.nrw - 1) / shape.nrw;
+    size_t ld = col_panels * shape.nrw;
+    hi.assign(row_panels * shape.mr * ld, 0.0);
+    lo.assign(hi.size(), 0.0);
+    if (exact) abs_sum.assign(hi.size(), 0.0);
+    apack.resize(row_panels * shape.mr * shape.kc);
+    bpack.resize(col_panels * shape.nrw * shape.kc);
+    GemmKernel kernel = shape.kernel[exact];
+
+    for (size_t k0 = 0; k0 < k_total; k0 += shape.kc){
+        size_t kc = min(shape.kc, k_total - k0);
+        // A как панели по mr строк: строка панели — столбец k
+        pack_panels(apack.data(), kc, mc, shape.mr, &a.data[(ptrdiff_t)i0 * a.row_stride + (ptrdiff_t)k0 * a.col_stride],
+                    a.col_stride, a.row_stride);
+        pack_panels(bpack.data(), kc, nc, shape.nrw, &b.data[(ptrdiff_t)k0 * b.row_stride + (ptrdiff_t)j0 * b.col_stride],
+                    b.row_stride, b.col_stride);
+        for (size_t q = 0; q < row_panels; q++){
+            for (size_t p = 0; p < col_panels; p++){
+                size_t offset = q * shape.mr * ld + p * shape.nrw;
+                kernel(&apack[q * kc * shape.mr], &bpack[p * kc * shape.nrw], kc,
+                       &hi[offset], &lo[offset], exact ? &abs_sum[offset] : nullptr, ld);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < mc; i++){
+        for (size_t j = 0; j < nc; j++){
+            size_t s = i * ld + j;
+            double result = hi[s] + lo[s];
+            if (exact && !certified_round(hi[s], lo[s], dot2_error_bound(k_total, abs_sum[s]), result)){
+                result = long_accumulator_dot_product(a.row(i0 + i), b.column(j0 + j));
+            }
+            c[(ptrdiff_t)(i0 + i) * c_row + (ptrdiff_t)(j0 + j) * c_col] = result;
+        }
+    }
+}
+
+static void gemm_blocked(const GemmShape& shape, MatrixView a, MatrixView b, double* c,
+                         ptrdiff_t c_row, ptrdiff_t c_col, GemmMode mode, size_t threads){
+    size_t m = a.rows, n = b.cols;
+    if (m == 0 || n == 0) return;
+    size_t blocks_i = (m + shape.mc - 1) / shape.mc;
+    size_t blocks_j = (n + shape.nc - 1) / shape.nc;
+    parallel_for(blocks_i * blocks_j, threads, [&](size_t t){
+        size_t i0 = t / blocks_j * shape.mc, j0 = t % blocks_j * shape.nc;
+        gemm_block(shape, a, b, i0, min(shape.mc, m - i0), j0, min(shape.nc, n - j0), c, c_row, c_col, mode);
+    });
+}
+
+void gemm(MatrixView a, MatrixView b, double* c, size_t ldc, GemmMode mode, size_t threads){
+    gemm_blocked(gemm_shapes().matrix, a, b, c, (ptrdiff_t)ldc, 1, mode, threads);
+}
+
+// Строк A на задачу parallel_for (кратно строкам ядра любого уровня) и
+// длина порции по k. При хранении по столбцам порция — 8 отрезков столбцов
+// по 4 КБ: ядра задачи проходят каждый сверху вниз, и аппаратная
+// предвыборка ведёт все 8 потоков сразу
+const size_t GEMV_TASK_ROWS = 512, GEMV_KC = 8;
+
+// y[i0 .. i0 + rows): ядром по shape.rows строк, остаток — по одной
+static void gemv_rows(const GemvShape& shape, MatrixView a, DotView x, size_t i0, size_t rows,
+                      double* y, ptrdiff_t y_stride, GemmMode mode){
+    const bool exact = mode == GemmMode::Exact;
+    double hi[GEMV_TASK_ROWS] = {}, lo[GEMV_TASK_ROWS] = {}, abs_sum[GEMV_TASK_ROWS] = {};
+    // По строкам каждая строка читается подряд целиком, делить k незачем
+    const size_t kc_max = a.col_stride == 1 ? max<size_t>(a.cols, 1) : GEMV_KC;
+    for (size_t k0 = 0; k0 < a.cols; k0 += kc_max){
+        size_t kc = min(kc_max, a.cols - k0);
+        for (size_t r = 0; r < rows;){
+            const double* block = a.data + (ptrdiff_t)(i0 + r) * a.row_stride + (ptrdiff_t)k0 * a.col_stride;
+            size_t count = r + shape.rows <= rows ? shape.rows : 1;
+            GemvKernel kernel = count > 1 ? shape.kernel[exact]
+                              : exact ? gemv_kernel_scalar<1, true> : gemv_kernel_scalar<1, false>;
+            kernel(block, a.row_stride, a.col_stride, x.data + (ptrdiff_t)k0 * x.stride, x.stride, kc,
+                   &hi[r], &lo[r], &abs_sum[r]);
+            r += count;
+        }
+    }
+    for (size_t r = 0; r < rows; r++){
+        double result = hi[r] + lo[r];
+        if (exact && !certified_round(hi[r], lo[r], dot2_error_bound(a.cols, abs_sum[r]), result)){
+            result = long_accumulator_dot_product(a.row(i0 + r), x);
+        }
+        y[(ptrdiff_t)(i0 + r) * y_stride] = result;
+    }
+}
+
+void gemv(MatrixView a, DotView x, double* y, ptrdiff_t y_stride, GemmMode mode, size_t threads){
+    const GemvShape& shape = gemm_shapes().vector;
+    size_t m = a.rows;
+    parallel_for((m + GEMV_TASK_ROWS - 1) / GEMV_TASK_ROWS, threads, [&](size_t t){
+        size_t i0 = t * GEMV_TASK_ROWS;
+        gemv_rows(shape, a, x, i0, min(GEMV_TASK_ROWS, m - i0), y, y_stride, mode);
+    });
+}
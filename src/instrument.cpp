@@ -0,0 +1,234 @@
+#include "instrument.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+
+#if defined(DOT_PRODUCT_INSTRUMENT) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define INSTRUMENT_HAVE_PERF 1
+#endif
+
+using namespace std;
+
+void DotStats::merge(const DotStats& other){
+    calls += other.calls;
+    elements += other.elements;
+    for (int p = 0; p < DOT_PHASES; p++) phase_ns[p] += other.phase_ns[p];
+    for (int e = 0; e < 2048; e++) exponent_histogram[e] += other.exponent_histogram[e];
+    zeros += other.zeros;
+    subnormals += other.subnormals;
+    infinities += other.infinities;
+    nans += other.nans;
+    abs_sum += other.abs_sum;
+    result_abs_sum += other.result_abs_sum;
+    max_cancellation = max(max_cancellation, other.max_cancellation);
+    auto add_counter = [](int64_t& to, int64_t from){
+        if (from < 0) return;
+        to = to < 0 ? from : to + from;
+    };
+    add_counter(cycles, other.cycles);
+    add_counter(instructions, other.instructions);
+    add_counter(cache_misses, other.cache_misses);
+}
+
+// Статистика всех алгоритмов; вызовы из разных потоков сливаются под мьютексом
+static mutex registry_mutex;
+static map<string, DotStats>& registry(){
+    static map<string, DotStats> stats;
+    return stats;
+}
+
+bool instrument_enabled(){
+#ifdef DOT_PRODUCT_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+DotStats instrument_stats(const char* algorithm){
+    lock_guard<mutex> lock(registry_mutex);
+    auto it = registry().find(algorithm);
+    return it == registry().end() ? DotStats() : it->second;
+}
+
+void instrument_reset(){
+    lock_guard<mutex> lock(registry_mutex);
+    registry().clear();
+}
+
+static const char* PHASE_NAMES[DOT_PHASES] = {"products", "accumulate", "finalize"};
+
+void instrument_report(FILE* out){
+    lock_guard<mutex> lock(registry_mutex);
+    fprintf(out, "{\n  \"enabled\": %s,\n  \"algorithms\": {", instrument_enabled() ? "true" : "false");
+    bool first = true;
+    for (const auto& entry : registry()){
+        const DotStats& s = entry.second;
+        fprintf(out, "%s\n    \"%s\": {\"calls\": %llu, \"elements\": %llu, \"phase_ns\": {",
+                first ? "" : ",", entry.first.c_str(),
+                (unsigned long long)s.calls, (unsigned long long)s.elements);
+        for (int p = 0; p < DOT_PHASES; p++){
+            fprintf(out, "%s\"%s\": %llu", p ? ", " : "", PHASE_NAMES[p], (unsigned long long)s.phase_ns[p]);
+        }
+        double ratio = s.result_abs_sum > 0.0 ? s.abs_sum / s.result_abs_sum : INFINITY;
+        fprintf(out, "}, \"zeros\": %llu, \"subnormals\": %llu, \"infinities\": %llu, \"nans\": %llu, ",
+                (unsigned long long)s.zeros, (unsigned long long)s.subnormals,
+                (unsigned long long)s.infinities, (unsigned long long)s.nans);
+        // JSON не умеет Infinity: полное сокращение (результат 0) — null
+        if (isfinite(ratio)) fprintf(out, "\"cancellation_ratio\": %.6g, ", ratio);
+        else fprintf(out, "\"cancellation_ratio\": null, ");
+        if (isfinite(s.max_cancellation)) fprintf(out, "\"max_cancellation_ratio\": %.6g, ", s.max_cancellation);
+        else fprintf(out, "\"max_cancellation_ratio\": null, ");
+        fprintf(out, "\"cycles\": %lld, \"instructions\": %lld, \"cache_misses\": %lld, \"exponent_histogram\": {",
+                (long long)s.cycles, (long long)s.instructions, (long long)s.cache_misses);
+        // Гистограмма разреженная: только непустые экспоненты, ключ — несмещённая
+        bool first_bin = true;
+        for (int e = 0; e < 2048; e++){
+            if (!s.exponent_histogram[e]) continue;
+            fprintf(out, "%s\"%d\": %llu", first_bin ? "" : ", ", e - 1023,
+                    (unsigned long long)s.exponent_histogram[e]);
+            first_bin = false;
+        }
+        fprintf(out, "}}");
+        first = false;
+    }
+    fprintf(out, "\n  }\n}\n");
+}
+
+void instrument_export(){
+    if (!instrument_enabled()) return;
+    const char* path = getenv("DOT_PRODUCT_STATS");
+    FILE* out = path ? fopen(path, "w") : stderr;
+    if (!out){
+        fprintf(stderr, "instrument: cannot open %s\n", path);
+        return;
+    }
+    instrument_report(out);
+    if (out != stderr) fclose(out);
+}
+
+#ifdef DOT_PRODUCT_INSTRUMENT
+static thread_local int call_depth = 0;
+
+#ifdef INSTRUMENT_HAVE_PERF
+// Счётчики открываются один раз на поток; если ядро не разрешает
+// perf_event_open (perf_event_paranoid, контейнер), они остаются -1
+struct PerfCounters {
+    int fd[3] = {-1, -1, -1};
+
+    PerfCounters(){
+        const uint64_t configs[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                     PERF_COUNT_HW_CACHE_MISSES};
+        for (int k = 0; k < 3; k++){
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[k];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+    }
+    ~PerfCounters(){
+        for (int k = 0; k < 3; k++) if (fd[k] >= 0) close(fd[k]);
+    }
+
+    void start(){
+        for (int k = 0; k < 3; k++){
+            if (fd[k] < 0) continue;
+            ioctl(fd[k], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd[k], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    void stop(DotStats& stats){
+        int64_t* out[3] = {&stats.cycles, &stats.instructions, &stats.cache_misses};
+        for (int k = 0; k < 3; k++){
+            if (fd[k] < 0) continue;
+            ioctl(fd[k], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t value;
+            if (read(fd[k], &value, sizeof(value)) == sizeof(value)) *out[k] = (int64_t)value;
+        }
+    }
+};
+
+static PerfCounters& perf_counters(){
+    static thread_local PerfCounters counters;
+    return counters;
+}
+#endif
+
+InstrumentCall::InstrumentCall(const char* algorithm) : algorithm(algorithm), active(call_depth++ == 0){
+    if (active) stats.calls = 1;
+}
+
+// Проход по входу до запуска таймеров и счётчиков: на время фаз не влияет
+InstrumentCall::InstrumentCall(const char* algorithm, DotView a, DotView b)
+    : InstrumentCall(algorithm, [&](auto record){
+          for (size_t i = 0; i < a.size; i++) record(a[i] * b[i]);
+      }) {}
+
+void InstrumentCall::record(double p){
+    stats.elements++;
+    uint64_t bits;
+    memcpy(&bits, &p, sizeof(double));
+    stats.exponent_histogram[(bits >> 52) & 0x7FF]++;
+    if (isnan(p)) stats.nans++;
+    else if (isinf(p)) stats.infinities++;
+    else if (p == 0.0) stats.zeros++;
+    else if (!isnormal(p)) stats.subnormals++;
+    if (isfinite(p)) stats.abs_sum += fabs(p);
+}
+
+void InstrumentCall::start_counters(){
+#ifdef INSTRUMENT_HAVE_PERF
+    perf_counters().start();
+#endif
+}
+
+void InstrumentCall::phase(DotPhase next){
+    if (!active) return;
+    auto now = chrono::steady_clock::now();
+    if (current >= 0){
+        stats.phase_ns[current] += chrono::duration_cast<chrono::nanoseconds>(now - phase_start).count();
+    }
+    current = (int)next;
+    phase_start = now;
+}
+
+double InstrumentCall::finish(double result){
+    if (!active || finished) return result;
+    if (current >= 0){
+        auto now = chrono::steady_clock::now();
+        stats.phase_ns[current] += chrono::duration_cast<chrono::nanoseconds>(now - phase_start).count();
+        current = -1;
+    }
+#ifdef INSTRUMENT_HAVE_PERF
+    perf_counters().stop(stats);
+#endif
+    if (isfinite(result)){
+        stats.result_abs_sum = fabs(result);
+        stats.max_cancellation = result != 0.0 ? stats.abs_sum / fabs(result)
+                                               : (stats.abs_sum > 0.0 ? INFINITY : 1.0);
+    }
+    finished = true;
+    return result;
+}
+
+InstrumentCall::~InstrumentCall(){
+    call_depth--;
+    if (!active) return;
+    if (!finished) finish(NAN);
+    lock_guard<mutex> lock(registry_mutex);
+    registry()[algorithm].merge(stats);
+}
+#endif
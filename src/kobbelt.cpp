@@ -1,4 +1,9 @@
 #include "kobbelt.hpp"
+#include "instrument.hpp"
+#include "long_accumulator.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <cstring>
 #include <cstdint>
@@ -6,38 +11,81 @@
 
 using namespace std;
 
-struct NumberInfo {
-    double value;
-    int exp;
-    bool is_even;
-};
+void KobbeltAccumulator::add(DotView a, DotView b){
+    for (size_t i = 0; i < a.size; i++){
+        add_product(a[i], b[i]);
+    }
+}
+
+void KobbeltAccumulator::renormalize(){
+    for (int e = 0; e < SIZE; e++){
+        if (high[e] != 0.0) spill.add(high[e]);
+        if (low[e] != 0.0) spill.add(low[e]);
+        high[e] = low[e] = 0.0;
+    }
+    pending = 0;
+}
+
+void KobbeltAccumulator::merge(const KobbeltAccumulator& other){
+    LongAccumulator rhs = other.spill;
+    for (int e = 0; e < SIZE; e++){
+        if (other.high[e] != 0.0) rhs.add(other.high[e]);
+        if (other.low[e] != 0.0) rhs.add(other.low[e]);
+    }
+    spill.merge(rhs);
+}
+
+// Точная свёртка таблицы и корректное округление
+double KobbeltAccumulator::finalize() const {
+    KobbeltAccumulator folded = *this;
+    folded.renormalize();
+    return folded.spill.round();
+}
+
+vector<uint8_t> KobbeltAccumulator::serialize() const {
+    KobbeltAccumulator folded = *this;
+    folded.renormalize();
+    return folded.spill.serialize();
+}
 
-NumberInfo get_number_info(double x){
-    NumberInfo info;
-    info.value = x;
-    int exp;
-    frexp(x, &exp);
-    info.exp = exp;
-    uint64_t bits;
-    memcpy(&bits, &x, sizeof(double));
-    info.is_even = (bits & 1) == 0;
-    return info;
+bool KobbeltAccumulator::deserialize(const uint8_t* data, size_t size){
+    LongAccumulator loaded;
+    if (!loaded.deserialize(data, size)) return false;
+    *this = KobbeltAccumulator();
+    spill = loaded;
+    return true;
 }
 
-void insert_into_table(vector<double>& table, double x){
-    NumberInfo info = get_number_info(x);
-    size_t index = 2 * (info.exp + 1024) + (info.is_even ? 0 : 1);
-    if (index >= table.size()) table.resize(index + 1, 0.0);
-    table[index] += x;
+double kobbelt_dot_product(DotView a, DotView b){
+    DOT_INSTRUMENT_CALL("Kobbelt", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    KobbeltAccumulator acc;
+    acc.add(a, b);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(acc.finalize());
 }
 
 double kobbelt_dot_product(const vector<double>& a, const vector<double>& b){
-    std::vector<double> table;
-    for (int i = 0; i < a.size(); i++){
-        double product = a[i] * b[i];
-        insert_into_table(table, product);
-    }
-    double sum = 0.0;
-    for (auto val : table) sum += val;
-    return sum;
-}
\ No newline at end of file
+    return kobbelt_dot_product(DotView(a), DotView(b));
+}
+
+double kobbelt_dot_product_parallel(DotView a, DotView b, size_t threads){
+    DOT_INSTRUMENT_CALL("Kobbelt MT", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    if (threads == 0) threads = default_thread_count();
+    size_t n = a.size;
+    size_t parts = max<size_t>(1, min(threads, n / PARALLEL_BLOCK));
+    vector<KobbeltAccumulator> partial(parts);
+    parallel_for(parts, parts, [&](size_t p){
+        size_t begin = n * p / parts, end = n * (p + 1) / parts;
+        partial[p].add(a.slice(begin, end - begin), b.slice(begin, end - begin));
+    });
+    // Слияние точное — порядок и число частей не влияют на результат
+    DOT_INSTRUMENT_PHASE(Finalize);
+    for (size_t p = 1; p < parts; p++) partial[0].merge(partial[p]);
+    return DOT_INSTRUMENT_RESULT(partial[0].finalize());
+}
+
+double kobbelt_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads){
+    return kobbelt_dot_product_parallel(DotView(a), DotView(b), threads);
+}
@@ -1,28 +1,110 @@
 #include "long_accumulator.hpp"
+#include "instrument.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
 using namespace std;
 
-struct DoubleDouble{
-    double hi; // Основная часть
-    double lo; // Корректирующая часть
-};
+// Распространение переносов: младшие разряды в [0, 2^32), старший знаковый
+void LongAccumulator::normalize(){
+    normalize_digits(digits, NUM_DIGITS);
+    pending = 0;
+}
+
+void LongAccumulator::merge(const LongAccumulator& other){
+    LongAccumulator rhs = other;
+    rhs.normalize();
+    normalize();                                // разряды < 2^32, сумма без переполнения
+    for (int i = 0; i < NUM_DIGITS; i++) digits[i] += rhs.digits[i];
+    pending = 1;
+    has_nan |= other.has_nan;
+    has_pos_inf |= other.has_pos_inf;
+    has_neg_inf |= other.has_neg_inf;
+}
+
+void LongAccumulator::add(DotView a, DotView b){
+    for (size_t i = 0; i < a.size; i++){
+        add_product(a[i], b[i]);
+    }
+}
+
+// Формат: "LACC", версия, флаги спецзначений, затем нормализованные
+// разряды — младшие как uint32, старший знаковый как int64
+static const uint8_t SERIAL_MAGIC[4] = {'L', 'A', 'C', 'C'};
+static const uint8_t SERIAL_VERSION = 1;
+
+vector<uint8_t> LongAccumulator::serialize() const {
+    LongAccumulator acc = *this;
+    acc.normalize();
+    vector<uint8_t> out(SERIAL_MAGIC, SERIAL_MAGIC + 4);
+    out.reserve(SERIALIZED_SIZE);
+    out.push_back(SERIAL_VERSION);
+    out.push_back((uint8_t)(has_nan | has_pos_inf << 1 | has_neg_inf << 2));
+    for (int i = 0; i < NUM_DIGITS - 1; i++) put_le(out, (uint64_t)acc.digits[i], 4);
+    put_le(out, (uint64_t)acc.digits[NUM_DIGITS - 1], 8);
+    return out;
+}
 
-void dd_add(DoubleDouble& sum, double x){
-    double s = sum.hi + x;
-    double e = (sum.hi - s) + x; // Компенсация ошибки
-    sum.hi = s;
-    sum.lo += e;
+bool LongAccumulator::deserialize(const uint8_t* data, size_t size){
+    if (size != SERIALIZED_SIZE || memcmp(data, SERIAL_MAGIC, 4) != 0) return false;
+    if (data[4] != SERIAL_VERSION || (data[5] & ~7) != 0) return false;
+    LongAccumulator acc;
+    acc.has_nan = (data[5] & 1) != 0;
+    acc.has_pos_inf = (data[5] & 2) != 0;
+    acc.has_neg_inf = (data[5] & 4) != 0;
+    const uint8_t* p = data + 6;
+    for (int i = 0; i < NUM_DIGITS - 1; i++, p += 4) acc.digits[i] = (int64_t)get_le(p, 4);
+    int64_t top = (int64_t)get_le(p, 8);
+    // Старший разряд с запасом под слияния, но далеко от переполнения int64
+    if (top > (1LL << 40) || top < -(1LL << 40)) return false;
+    acc.digits[NUM_DIGITS - 1] = top;
+    *this = acc;
+    return true;
 }
 
-double dd_get(const DoubleDouble& sum){
-    return sum.hi + sum.lo;
+double LongAccumulator::round(int scale) const {
+    if (has_nan || (has_pos_inf && has_neg_inf)) return numeric_limits<double>::quiet_NaN();
+    if (has_pos_inf) return numeric_limits<double>::infinity();
+    if (has_neg_inf) return -numeric_limits<double>::infinity();
+
+    LongAccumulator acc = *this;
+    return round_digits(acc.digits, NUM_DIGITS, MIN_EXP, scale);
+}
+
+double long_accumulator_dot_product(DotView a, DotView b){
+    DOT_INSTRUMENT_CALL("Long Acc", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    LongAccumulator acc;
+    acc.add(a, b);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(acc.round());
 }
 
 double long_accumulator_dot_product(const vector<double>& a, const vector<double>& b){
-    DoubleDouble sum{0.0, 0.0};
-    for (int i = 0; i < a.size(); i++){
-        dd_add(sum, a[i] * b[i]);
-    }
-    return dd_get(sum);
-}
\ No newline at end of file
+    return long_accumulator_dot_product(DotView(a), DotView(b));
+}
+
+double long_accumulator_dot_product_parallel(DotView a, DotView b, size_t threads){
+    DOT_INSTRUMENT_CALL("Long MT", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    if (threads == 0) threads = default_thread_count();
+    size_t n = a.size;
+    size_t parts = max<size_t>(1, min(threads, n / PARALLEL_BLOCK));
+    vector<LongAccumulator> partial(parts);
+    parallel_for(parts, parts, [&](size_t p){
+        size_t begin = n * p / parts, end = n * (p + 1) / parts;
+        partial[p].add(a.slice(begin, end - begin), b.slice(begin, end - begin));
+    });
+    DOT_INSTRUMENT_PHASE(Finalize);
+    for (size_t p = 1; p < parts; p++) partial[0].merge(partial[p]);
+    return DOT_INSTRUMENT_RESULT(partial[0].round());
+}
+
+double long_accumulator_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads){
+    return long_accumulator_dot_product_parallel(DotView(a), DotView(b), threads);
+}
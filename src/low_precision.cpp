@@ -0,0 +1,279 @@
+#include "low_precision.hpp"
+#include "cpu_dispatch.hpp"
+#include "instrument.hpp"
+#include "long_accumulator.hpp"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOW_PRECISION_HAVE_X86 1
+#endif
+
+using namespace std;
+
+// Вход обрабатывается блоками: произведения (и преобразованные половинки)
+// лежат в буферах на стеке
+static const size_t BLOCK = 512;
+
+// ── Произведения float → double ─────────────────────────────────────────────
+typedef void (*ProductKernel)(const float*, const float*, size_t, double*);
+
+static void products_scalar(const float* a, const float* b, size_t n, double* out){
+    for (size_t i = 0; i < n; i++) out[i] = (double)a[i] * (double)b[i];
+}
+
+#ifdef LOW_PRECISION_HAVE_X86
+__attribute__((target("avx2")))
+static void products_avx2(const float* a, const float* b, size_t n, double* out){
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4){
+        __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(a + i));
+        __m256d y = _mm256_cvtps_pd(_mm_loadu_ps(b + i));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(x, y));
+    }
+    for (; i < n; i++) out[i] = (double)a[i] * (double)b[i];
+}
+
+__attribute__((target("avx512f")))
+static void products_avx512(const float* a, const float* b, size_t n, double* out){
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m512d x = _mm512_cvtps_pd(_mm256_loadu_ps(a + i));
+        __m512d y = _mm512_cvtps_pd(_mm256_loadu_ps(b + i));
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(x, y));
+    }
+    for (; i < n; i++) out[i] = (double)a[i] * (double)b[i];
+}
+#endif
+
+// Произведения точны, поэтому все ядра дают одинаковые биты
+static ProductKernel select_product_kernel(){
+#ifdef LOW_PRECISION_HAVE_X86
+    switch (detect_simd_level()){
+        case SimdLevel::AVX512: return products_avx512;
+        case SimdLevel::AVX2:   return products_avx2;
+        default: break;
+    }
+#endif
+    return products_scalar;
+}
+
+static ProductKernel product_kernel(){
+    static const ProductKernel kernel = select_product_kernel();
+    return kernel;
+}
+
+// ── 16-битные форматы ───────────────────────────────────────────────────────
+float half_to_float(uint16_t bits, HalfFormat format){
+    uint32_t sign = (uint32_t)(bits >> 15) << 31;
+    uint32_t out;
+    if (format == HalfFormat::BFloat16){
+        out = (uint32_t)bits << 16;
+    } else {
+        uint32_t exp = (bits >> 10) & 0x1F;
+        uint32_t frac = bits & 0x3FF;
+        if (exp == 0){
+            float value = (float)frac * 0x1p-24f;   // ноль и субнормали точно
+            return sign ? -value : value;
+        }
+        if (exp == 0x1F) out = sign | 0x7F800000u | frac << 13;
+        else out = sign | (exp - 15 + 127) << 23 | frac << 13;
+    }
+    float x;
+    memcpy(&x, &out, sizeof(float));
+    return x;
+}
+
+typedef void (*HalfKernel)(const uint16_t*, size_t, float*);
+
+static void binary16_scalar(const uint16_t* in, size_t n, float* out){
+    for (size_t i = 0; i < n; i++) out[i] = half_to_float(in[i], HalfFormat::Binary16);
+}
+
+static void bfloat16_scalar(const uint16_t* in, size_t n, float* out){
+    for (size_t i = 0; i < n; i++){
+        uint32_t bits = (uint32_t)in[i] << 16;
+        memcpy(&out[i], &bits, sizeof(float));
+    }
+}
+
+#ifdef LOW_PRECISION_HAVE_X86
+__attribute__((target("avx2,f16c")))
+static void binary16_f16c(const uint16_t* in, size_t n, float* out){
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m128i h = _mm_loadu_si128((const __m128i*)(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+    }
+    binary16_scalar(in + i, n - i, out + i);
+}
+#endif
+
+static HalfKernel select_binary16_kernel(){
+#ifdef LOW_PRECISION_HAVE_X86
+    if (detect_simd_level() >= SimdLevel::AVX2 && __builtin_cpu_supports("f16c")) return binary16_f16c;
+#endif
+    return binary16_scalar;
+}
+
+static HalfKernel half_kernel(HalfFormat format){
+    static const HalfKernel binary16 = select_binary16_kernel();
+    return format == HalfFormat::Binary16 ? binary16 : bfloat16_scalar;
+}
+
+// ── Точная сумма произведений float ─────────────────────────────────────────
+// Точное произведение float — double с мантиссой не длиннее 48 бит (младшие
+// 5 бит 53-битной мантиссы нулевые) и смещённой экспонентой от 725
+// (2^-298) до 1278 (< 2^256). Знаковые мантиссы копятся в int64 по
+// экспоненте: 2^15 слагаемых меньше 2^48 не переполняют корзину.
+class ProductBuckets {
+public:
+    void add(const double* p, size_t count){
+        if (pending + count > FLUSH_INTERVAL) flush();
+        pending += (uint32_t)count;
+        for (size_t i = 0; i < count; i++){
+            uint64_t bits;
+            memcpy(&bits, &p[i], sizeof(double));
+            int e = (int)((bits >> 52) & 0x7FF);
+            if (e == 0x7FF){
+                acc.add(p[i]);                  // Inf или NaN (в том числе Inf·0)
+                continue;
+            }
+            int64_t m = (int64_t)(((bits & ((1ULL << 52) - 1)) | (uint64_t)(e != 0) << 52) >> 5);
+            bucket[e] += (int64_t)bits < 0 ? -m : m;
+        }
+    }
+
+    void flush(){
+        for (int e = EXP_MIN; e <= EXP_MAX; e++){
+            int64_t v = bucket[e];
+            if (!v) continue;
+            acc.add_scaled(v < 0 ? -(uint64_t)v : (uint64_t)v, e - 1075 + 5, v < 0);
+            bucket[e] = 0;
+        }
+        pending = 0;
+    }
+
+    // Корректное округление к double
+    double result(){
+        flush();
+        return acc.round();
+    }
+
+    // Корректное округление к float. Округление к double и затем к float
+    // может ошибиться на середине между соседними float, поэтому к double
+    // округляем «к нечётному»: отбрасываем хвост, а при ненулевом хвосте
+    // ставим младший бит. 53 бита — не меньше 24 + 2, и второе округление
+    // даёт правильный float.
+    float result_single(){
+        flush();
+        double d = acc.round();
+        if (!isfinite(d)) return (float)d;
+        LongAccumulator rest = acc;
+        rest.add(-d);
+        double r = rest.round();                // знак хвоста: точное = d + r
+        if (r == 0.0) return (float)d;
+        double t = d;
+        if (d == 0.0) t = copysign(0.0, r);
+        else if (signbit(r) != signbit(d)) t = nextafter(d, 0.0);   // |точное| < |d|
+        uint64_t bits;
+        memcpy(&bits, &t, sizeof(double));
+        bits |= 1;
+        memcpy(&t, &bits, sizeof(double));
+        return (float)t;
+    }
+
+private:
+    static const uint32_t FLUSH_INTERVAL = 1u << 15;
+    static const int EXP_MIN = 725;
+    static const int EXP_MAX = 1278;
+
+    int64_t bucket[2048] = {};
+    uint32_t pending = 0;
+    LongAccumulator acc;
+};
+
+static void add_float_products(ProductBuckets& buckets, const float* a, const float* b, size_t n){
+    double products[BLOCK];
+    ProductKernel kernel = product_kernel();
+    for (size_t begin = 0; begin < n; begin += BLOCK){
+        size_t count = min(BLOCK, n - begin);
+        kernel(a + begin, b + begin, count, products);
+        buckets.add(products, count);
+    }
+}
+
+static void add_half_products(ProductBuckets& buckets, const uint16_t* a, const uint16_t* b, size_t n, HalfFormat format){
+    float fa[BLOCK], fb[BLOCK];
+    HalfKernel widen = half_kernel(format);
+    for (size_t begin = 0; begin < n; begin += BLOCK){
+        size_t count = min(BLOCK, n - begin);
+        widen(a + begin, count, fa);
+        widen(b + begin, count, fb);
+        add_float_products(buckets, fa, fb, count);
+    }
+}
+
+double float_dot_product(const float* a, const float* b, size_t n){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Float", [&](auto record){
+        for (size_t i = 0; i < n; i++) record((double)a[i] * b[i]);
+    });
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    ProductBuckets buckets;
+    add_float_products(buckets, a, b, n);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(buckets.result());
+}
+
+double float_dot_product(const vector<float>& a, const vector<float>& b){
+    return float_dot_product(a.data(), b.data(), a.size());
+}
+
+float float_dot_product_single(const float* a, const float* b, size_t n){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Float single", [&](auto record){
+        for (size_t i = 0; i < n; i++) record((double)a[i] * b[i]);
+    });
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    ProductBuckets buckets;
+    add_float_products(buckets, a, b, n);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return (float)DOT_INSTRUMENT_RESULT((double)buckets.result_single());
+}
+
+// Имена в отчёте инструментирования: [формат][результат float]
+static const char* const HALF_NAMES[2][2] = {{"FP16", "FP16 single"}, {"BF16", "BF16 single"}};
+
+double half_dot_product(const uint16_t* a, const uint16_t* b, size_t n, HalfFormat format){
+    DOT_INSTRUMENT_CALL_PRODUCTS(HALF_NAMES[(int)format][0], [&](auto record){
+        for (size_t i = 0; i < n; i++) record((double)half_to_float(a[i], format) * half_to_float(b[i], format));
+    });
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    ProductBuckets buckets;
+    add_half_products(buckets, a, b, n, format);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(buckets.result());
+}
+
+float half_dot_product_single(const uint16_t* a, const uint16_t* b, size_t n, HalfFormat format){
+    DOT_INSTRUMENT_CALL_PRODUCTS(HALF_NAMES[(int)format][1], [&](auto record){
+        for (size_t i = 0; i < n; i++) record((double)half_to_float(a[i], format) * half_to_float(b[i], format));
+    });
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    ProductBuckets buckets;
+    add_half_products(buckets, a, b, n, format);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return (float)DOT_INSTRUMENT_RESULT((double)buckets.result_single());
+}
+
+double mixed_dot_product(const float* a, DotView b){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Mixed", [&](auto record){
+        for (size_t i = 0; i < b.size; i++) record((double)a[i] * b[i]);
+    });
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    LongAccumulator acc;
+    for (size_t i = 0; i < b.size; i++) acc.add_product((double)a[i], b[i]);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(acc.round());
+}
@@ -1,14 +1,25 @@
+#include "adaptive.hpp"
+#include "binned.hpp"
+#include "dotk.hpp"
 #include "merge.hpp"
 #include "fma.hpp"
 #include "kobbelt.hpp"
 #include "long_accumulator.hpp"
+#include "narrow.hpp"
 #include "pichat.hpp"
 #include "sorting.hpp"
+#include "instrument.hpp"
+#include "vector_file.hpp"
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cstdint>
 #include <cmath>
+#include <random>
+#include <string>
 
 using namespace std;
 
@@ -35,7 +46,7 @@ void print_vector_summary(const std::vector<double>& v, const std::string& name)
 }
 
 
-int main(){
+static int run_demo(){
     vector<double> a = {1.0, 2.0, 3.0, 1e300, 1e-300};
     vector<double> b = {4.0, 5.0, 6.0, 1e-300, 1e300};
 
@@ -52,6 +63,171 @@ int main(){
     cout << "Long Acc:     " << res_long << "\n";
     cout << "Pichat:       " << res_pichat << "\n";
     cout << "Sorting:      " << res_sorting << "\n";
+    return 0;
+}
+
+// ── Запуск на файлах .dotv (include/vector_file.hpp) ─────────────────────────
+//
+//   main                                      демонстрация на встроенных векторах
+//   main [опции] ФАЙЛ[:столбец] [ФАЙЛ[:столбец]]
+//       один операнд — столбцы c и c + 1 одного файла (c = 0 по умолчанию)
+//       --algorithm ИМЯ   merge, fma, kobbelt, long, pichat, sorting, auto,
+//                         binned, narrow, dotk2 … dotk8, merge-mt, kobbelt-mt,
+//                         long-mt, binned-mt
+//                         или all (по умолчанию auto)
+//       --threads N       потоки для *-mt (0 — все ядра)
+//       --repeat N        число прогонов, время — лучшее
+//   main --generate ФАЙЛ СТРОК СТОЛБЦОВ [СИД]
+//       случайные числа с равномерным логарифмом в [2^-300, 2^300]
+
+static size_t driver_threads = 0;
+
+static double merge_mt(DotView a, DotView b){ return merge_dot_product_parallel(a, b, driver_threads); }
+static double kobbelt_mt(DotView a, DotView b){ return kobbelt_dot_product_parallel(a, b, driver_threads); }
+static double long_mt(DotView a, DotView b){ return long_accumulator_dot_product_parallel(a, b, driver_threads); }
+static double binned_mt(DotView a, DotView b){ return binned_dot_product_parallel(a, b, driver_threads); }
 
+struct DriverAlgorithm {
+    const char* name;
+    double (*run)(DotView, DotView);
+};
+
+static const DriverAlgorithm DRIVER_ALGORITHMS[] = {
+    {"merge", merge_dot_product},
+    {"fma", fma_dot_product},
+    {"kobbelt", kobbelt_dot_product},
+    {"long", long_accumulator_dot_product},
+    {"pichat", pichat_dot_product},
+    {"sorting", sorting_dot_product},
+    {"auto", auto_dot_product},
+    {"binned", binned_dot_product},
+    {"narrow", narrow_dot_product},
+    {"dotk2", dotk_dot_product<2>},
+    {"dotk3", dotk_dot_product<3>},
+    {"dotk4", dotk_dot_product<4>},
+    {"dotk5", dotk_dot_product<5>},
+    {"dotk6", dotk_dot_product<6>},
+    {"dotk7", dotk_dot_product<7>},
+    {"dotk8", dotk_dot_product<8>},
+    {"merge-mt", merge_mt},
+    {"kobbelt-mt", kobbelt_mt},
+    {"long-mt", long_mt},
+    {"binned-mt", binned_mt},
+};
+
+// "путь:столбец"; без суффикса столбец не задан (column = -1)
+struct OperandSpec {
+    string path;
+    long column = -1;
+};
+
+static OperandSpec parse_operand(const string& arg){
+    OperandSpec spec{arg};
+    size_t colon = arg.rfind(':');
+    if (colon != string::npos && colon + 1 < arg.size()
+        && arg.find_first_not_of("0123456789", colon + 1) == string::npos){
+        spec.path = arg.substr(0, colon);
+        spec.column = strtol(arg.c_str() + colon + 1, nullptr, 10);
+    }
+    return spec;
+}
+
+static int usage(const char* program){
+    fprintf(stderr,
+            "usage: %s [--algorithm NAME|all] [--threads N] [--repeat N] FILE[:COL] [FILE[:COL]]\n"
+            "       %s --generate FILE ROWS COLUMNS [SEED]\n", program, program);
+    return 1;
+}
+
+static int run_generate(const char* path, size_t rows, size_t columns, uint64_t seed){
+    mt19937_64 rng(seed);
+    uniform_real_distribution<> uni01(0.0, 1.0);
+    vector<vector<double>> data(columns, vector<double>(rows));
+    for (size_t r = 0; r < rows; r++){
+        for (size_t c = 0; c < columns; c++){
+            int e = uniform_int_distribution<int>(-300, 300)(rng);
+            double m = ldexp(uni01(rng) + 1.0, -1);
+            data[c][r] = copysign(ldexp(m, e), rng() & 1 ? 1.0 : -1.0);
+        }
+    }
+    vector<DotView> views(data.begin(), data.end());
+    if (!write_vector_file(path, views)){
+        fprintf(stderr, "%s: write failed\n", path);
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+static int run_files(const vector<OperandSpec>& operands, const string& algorithm, size_t repeat){
+    MappedVectorFile files[2];
+    DotView views[2] = {DotView(nullptr, 0), DotView(nullptr, 0)};
+    for (size_t k = 0; k < 2; k++){
+        // Один операнд — оба столбца из одного файла: c и c + 1
+        const OperandSpec& spec = operands[operands.size() == 1 ? 0 : k];
+        MappedVectorFile& file = files[operands.size() == 1 ? 0 : k];
+        if (k == 0 || operands.size() == 2){
+            if (!file.open(spec.path)){
+                fprintf(stderr, "%s\n", file.error().c_str());
+                return 1;
+            }
+            file.advise_sequential();
+        }
+        size_t column = (spec.column >= 0 ? (size_t)spec.column : 0) + (operands.size() == 1 ? k : 0);
+        if (column >= file.columns()){
+            fprintf(stderr, "%s: no column %zu (file has %zu)\n", spec.path.c_str(), column, file.columns());
+            return 1;
+        }
+        views[k] = file.column(column);
+    }
+    if (views[0].size != views[1].size){
+        fprintf(stderr, "operand lengths differ: %zu and %zu\n", views[0].size, views[1].size);
+        return 1;
+    }
+
+    bool found = false;
+    for (const DriverAlgorithm& algo : DRIVER_ALGORITHMS){
+        if (algorithm != "all" && algorithm != algo.name) continue;
+        found = true;
+        double result = 0.0;
+        double best = INFINITY;
+        for (size_t r = 0; r < repeat; r++){
+            auto start = chrono::steady_clock::now();
+            result = algo.run(views[0], views[1]);
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        printf("%-11s %.17g  %a  %.3f ms  %.3f GB/s\n", algo.name, result, result, best * 1e3,
+               2.0 * sizeof(double) * views[0].size / best * 1e-9);
+    }
+    if (!found){
+        fprintf(stderr, "unknown algorithm: %s\n", algorithm.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv){
+    int status;
+    if (argc == 1){
+        status = run_demo();
+    } else if (!strcmp(argv[1], "--generate")){
+        if (argc < 5 || argc > 6) return usage(argv[0]);
+        status = run_generate(argv[2], strtoull(argv[3], nullptr, 10), strtoull(argv[4], nullptr, 10),
+                              argc == 6 ? strtoull(argv[5], nullptr, 10) : 20250423);
+    } else {
+        string algorithm = "auto";
+        size_t repeat = 1;
+        vector<OperandSpec> operands;
+        for (int i = 1; i < argc; i++){
+            if (!strcmp(argv[i], "--algorithm") && i + 1 < argc) algorithm = argv[++i];
+            else if (!strcmp(argv[i], "--threads") && i + 1 < argc) driver_threads = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+            else if (argv[i][0] == '-') return usage(argv[0]);
+            else operands.push_back(parse_operand(argv[i]));
+        }
+        if (operands.empty() || operands.size() > 2) return usage(argv[0]);
+        status = run_files(operands, algorithm, repeat);
+    }
+
+    instrument_export();
+    return status;
+}
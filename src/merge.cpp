@@ -1,45 +1,226 @@
 #include "merge.hpp"
+#include "eft.hpp"
+#include "eft_simd.hpp"
+#include "instrument.hpp"
+#include "cpu_dispatch.hpp"
+#include "long_accumulator.hpp"
+#include "parallel.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <vector>
 #include <cstdio>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MERGE_HAVE_X86 1
+#endif
+
 using namespace std;
 
-struct DoubleDouble{
-    double hi; // Основная часть
-    double lo; // Корректирующая часть
-};
+// Элементы [begin, end) — элемент i попадает в цепочку i % MERGE_LANES.
+// С TrackAbs цепочки заодно копят sum |a_i·b_i| для оценки погрешности.
+template<bool TrackAbs>
+static void merge_lanes_scalar(DotView a, DotView b, size_t begin, size_t end,
+                               double* hi, double* lo, double* abs_sum){
+    for (size_t i = begin; i < end; i++){
+        size_t k = i % MERGE_LANES;
+        dot2_update(hi[k], lo[k], a[i], b[i]);
+        if (TrackAbs) abs_sum[k] += fabs(a[i] * b[i]);
+    }
+}
+
+// Ядро обрабатывает первые n элементов (n кратно MERGE_LANES)
+typedef void (*MergeKernel)(const double*, const double*, size_t, double*, double*, double*);
+
+template<bool TrackAbs>
+static void merge_kernel_scalar(const double* a, const double* b, size_t n, double* hi, double* lo, double* abs_sum){
+    merge_lanes_scalar<TrackAbs>(DotView(a, n), DotView(b, n), 0, n, hi, lo, abs_sum);
+}
+
+#ifdef MERGE_HAVE_X86
+template<bool TrackAbs>
+__attribute__((target("sse2")))
+static void merge_kernel_sse2(const double* a, const double* b, size_t n, double* hi, double* lo, double* abs_sum){
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d h[8], l[8], m[8];
+    for (int k = 0; k < 8; k++){
+        h[k] = _mm_loadu_pd(hi + 2 * k);
+        l[k] = _mm_loadu_pd(lo + 2 * k);
+        if (TrackAbs) m[k] = _mm_loadu_pd(abs_sum + 2 * k);
+    }
+    for (size_t i = 0; i < n; i += MERGE_LANES){
+        for (int k = 0; k < 8; k++){
+            const double* pa = a + i + 2 * k;
+            const double* pb = b + i + 2 * k;
+            __m128d x = _mm_loadu_pd(pa);
+            __m128d y = _mm_loadu_pd(pb);
+            __m128d p = _mm_mul_pd(x, y);
+            // В SSE2 нет FMA: ошибку произведения считаем скалярно
+            double pp[2];
+            _mm_storeu_pd(pp, p);
+            __m128d e = _mm_set_pd(fma(pa[1], pb[1], -pp[1]), fma(pa[0], pb[0], -pp[0]));
+            __m128d s = _mm_add_pd(h[k], p);
+            __m128d z = _mm_sub_pd(s, h[k]);
+            __m128d t = _mm_add_pd(_mm_sub_pd(h[k], _mm_sub_pd(s, z)), _mm_sub_pd(p, z));
+            h[k] = s;
+            l[k] = _mm_add_pd(l[k], _mm_add_pd(t, e));
+            if (TrackAbs) m[k] = _mm_add_pd(m[k], _mm_andnot_pd(sign, p));
+        }
+    }
+    for (int k = 0; k < 8; k++){
+        _mm_storeu_pd(hi + 2 * k, h[k]);
+        _mm_storeu_pd(lo + 2 * k, l[k]);
+        if (TrackAbs) _mm_storeu_pd(abs_sum + 2 * k, m[k]);
+    }
+}
 
-void dod_add(DoubleDouble& sum, double x, double err){
-    double s1 = sum.hi + x;
-    double e1 = (sum.hi - s1) + x;
-    
-    double s2 = s1 + (e1 + err + sum.lo);
-    double e2 = (s1 - s2) + (e1 + err + sum.lo);
-    
-    sum.hi = s2;
-    sum.lo = e2;
+template<bool TrackAbs>
+__attribute__((target("avx2,fma")))
+static void merge_kernel_avx2(const double* a, const double* b, size_t n, double* hi, double* lo, double* abs_sum){
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d h[4], l[4], m[4];
+    for (int k = 0; k < 4; k++){
+        h[k] = _mm256_loadu_pd(hi + 4 * k);
+        l[k] = _mm256_loadu_pd(lo + 4 * k);
+        if (TrackAbs) m[k] = _mm256_loadu_pd(abs_sum + 4 * k);
+    }
+    for (size_t i = 0; i < n; i += MERGE_LANES){
+        for (int k = 0; k < 4; k++){
+            __m256d x = _mm256_loadu_pd(a + i + 4 * k);
+            __m256d y = _mm256_loadu_pd(b + i + 4 * k);
+            __m256d p = dot2_step_avx2(h[k], l[k], x, y);
+            if (TrackAbs) m[k] = _mm256_add_pd(m[k], _mm256_andnot_pd(sign, p));
+        }
+    }
+    for (int k = 0; k < 4; k++){
+        _mm256_storeu_pd(hi + 4 * k, h[k]);
+        _mm256_storeu_pd(lo + 4 * k, l[k]);
+        if (TrackAbs) _mm256_storeu_pd(abs_sum + 4 * k, m[k]);
+    }
 }
 
-double dod_get(const DoubleDouble& sum){
-    double result = sum.hi + sum.lo;
-    double residual = (sum.hi - result) + sum.lo;
-    return result + residual;
+template<bool TrackAbs>
+__attribute__((target("avx512f")))
+static void merge_kernel_avx512(const double* a, const double* b, size_t n, double* hi, double* lo, double* abs_sum){
+    __m512d h[2], l[2], m[2];
+    for (int k = 0; k < 2; k++){
+        h[k] = _mm512_loadu_pd(hi + 8 * k);
+        l[k] = _mm512_loadu_pd(lo + 8 * k);
+        if (TrackAbs) m[k] = _mm512_loadu_pd(abs_sum + 8 * k);
+    }
+    for (size_t i = 0; i < n; i += MERGE_LANES){
+        for (int k = 0; k < 2; k++){
+            __m512d x = _mm512_loadu_pd(a + i + 8 * k);
+            __m512d y = _mm512_loadu_pd(b + i + 8 * k);
+            __m512d p = dot2_step_avx512(h[k], l[k], x, y);
+            if (TrackAbs) m[k] = _mm512_add_pd(m[k], _mm512_abs_pd(p));
+        }
+    }
+    for (int k = 0; k < 2; k++){
+        _mm512_storeu_pd(hi + 8 * k, h[k]);
+        _mm512_storeu_pd(lo + 8 * k, l[k]);
+        if (TrackAbs) _mm512_storeu_pd(abs_sum + 8 * k, m[k]);
+    }
 }
+#endif
 
-// Точное умножение с использованием FMA
-pair<double, double> exact_multiply(double a, double b){
-    double prod = a * b;
-    double err = fma(a, b, -prod); // Вычисление ошибки
-    return {prod, err};
+template<bool TrackAbs>
+static MergeKernel select_merge_kernel(){
+#ifdef MERGE_HAVE_X86
+    switch (detect_simd_level()){
+        case SimdLevel::AVX512: return merge_kernel_avx512<TrackAbs>;
+        case SimdLevel::AVX2:   return merge_kernel_avx2<TrackAbs>;
+        case SimdLevel::SSE2:   return merge_kernel_sse2<TrackAbs>;
+        default:                break;
+    }
+#endif
+    return merge_kernel_scalar<TrackAbs>;
 }
 
-double merge_dot_product(const vector<double>& a, const vector<double>& b){
+// Одна последовательная цепочка — исходный вариант алгоритма
+static DoubleDouble merge_serial(DotView a, DotView b){
     DoubleDouble sum{0.0, 0.0};
-    for (int i = 0 ; i < a.size(); i++){
+    for (size_t i = 0; i < a.size; i++){
         pair<double,double> sump = exact_multiply(a[i], b[i]);
         dod_add(sum, sump.first, sump.second);
     }
-    return dod_get(sum);
+    return sum;
+}
+
+// Непрерывные данные идут в SIMD-ядро, данные с шагом — в скалярные
+// цепочки с тем же распределением элементов, поэтому результат совпадает
+template<bool TrackAbs>
+static DoubleDouble merge_lanes(DotView a, DotView b, double* abs_sum){
+    static const MergeKernel kernel = select_merge_kernel<TrackAbs>();
+
+    double hi[MERGE_LANES] = {};
+    double lo[MERGE_LANES] = {};
+    size_t n = a.size;
+    size_t body = 0;
+    if (a.contiguous() && b.contiguous()){
+        body = n - n % MERGE_LANES;
+        kernel(a.data, b.data, body, hi, lo, abs_sum);
+    }
+    merge_lanes_scalar<TrackAbs>(a, b, body, n, hi, lo, abs_sum);
+    return merge_lanes_result(hi, lo);
+}
+
+static DoubleDouble merge_block(DotView a, DotView b){
+    DoubleDouble sum = merge_lanes<false>(a, b, nullptr);
+    // Цепочка могла переполниться там, где в общей последовательности
+    // слагаемые взаимно гасятся (±1e308) — пересчитываем одной цепочкой
+    if (!isfinite(dod_get(sum))) return merge_serial(a, b);
+    return sum;
+}
+
+double merge_dot_product(DotView a, DotView b){
+    DOT_INSTRUMENT_CALL("Merge", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    DoubleDouble sum = merge_block(a, b);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(dod_get(sum));
+}
+
+double merge_dot_product(const vector<double>& a, const vector<double>& b){
+    return merge_dot_product(DotView(a), DotView(b));
+}
+
+DoubleDouble merge_dot_product_bounded(DotView a, DotView b, double& abs_sum){
+    double lanes[MERGE_LANES] = {};
+    DoubleDouble sum = merge_lanes<true>(a, b, lanes);
+    abs_sum = 0.0;
+    for (size_t k = 0; k < MERGE_LANES; k++) abs_sum += lanes[k];
+    return sum;
+}
+
+void MergeAccumulator::add(DotView a, DotView b){
+    DoubleDouble partial = merge_block(a, b);
+    exact.add(partial.hi);
+    exact.add(partial.lo);
+}
+
+double merge_dot_product_parallel(DotView a, DotView b, size_t threads){
+    DOT_INSTRUMENT_CALL("Merge MT", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    size_t n = a.size;
+    size_t blocks = (n + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+    vector<DoubleDouble> partial(blocks);
+    parallel_for(blocks, threads, [&](size_t k){
+        size_t begin = k * PARALLEL_BLOCK;
+        size_t count = min(n - begin, PARALLEL_BLOCK);
+        partial[k] = merge_block(a.slice(begin, count), b.slice(begin, count));
+    });
+    // Частичные суммы складываются точно — порядок слияния не важен
+    DOT_INSTRUMENT_PHASE(Finalize);
+    LongAccumulator acc;
+    for (const DoubleDouble& p : partial){
+        acc.add(p.hi);
+        acc.add(p.lo);
+    }
+    return DOT_INSTRUMENT_RESULT(acc.round());
+}
+
+double merge_dot_product_parallel(const vector<double>& a, const vector<double>& b, size_t threads){
+    return merge_dot_product_parallel(DotView(a), DotView(b), threads);
 }
@@ -0,0 +1,89 @@
+#include "narrow.hpp"
+#include "digit_split.hpp"
+#include "instrument.hpp"
+#include "long_accumulator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+// Нормальное x = m·2^(e-1075), e — смещённая экспонента. Произведение
+// m_a·m_b·2^(e_a+e_b-2150) — целое кратное 2^L, L = k_min - 2150, где
+// k = e_a + e_b — его ключ; по модулю оно меньше 2^T, T = k_max - 2150 + 106.
+static const int KEY_BIAS = 2150;
+static const int PRODUCT_BITS = 106;
+
+// Ключи блока, при которых весь путь точен: снизу ошибка TwoProd и все
+// остатки — кратные 2^L >= 2^-1074, сверху константы выделения и суммы
+// разрядов (меньше 2^(T+53)) далеко от переполнения
+static const int MIN_KEY = KEY_BIAS - 1074;
+static const int MAX_KEY = 3000;
+
+// Ширина разряда. Разряд j — кратные 2^β_j, β_j = L + 40·j; обе части
+// TwoProd — кратные 2^L, меньше 2^(β_{D-1}+40), поэтому остаток в разряде 0
+// точен. Слагаемые разряда по модулю меньше 2^(β+41), и суммы блока точны
+// (см. digit_split.hpp).
+static const int DIGIT_BITS = 40;
+static const int MAX_DIGITS = 6;            // (106 + NARROW_WINDOW + 39) / 40
+static_assert(MAX_DIGITS <= SPLIT_MAX_DIGITS && NARROW_BLOCK <= SPLIT_BLOCK, "narrow: блок шире ядер разрядов");
+
+// Блок разрядами, если ключи укладываются в окно; false — блок нужно
+// считать длинным аккумулятором
+static bool add_narrow_block(LongAccumulator& acc, const double* a, const double* b, size_t n){
+    KeyRange range;
+    scan_keys(a, b, n, range);
+
+    if (range.max_exp == 2047 || range.min_exp == 0) return false;  // Inf, NaN, субнормаль
+    if (range.min_key > range.max_key) return true;                 // все произведения нулевые
+    if (range.min_key < MIN_KEY || range.max_key > MAX_KEY) return false;
+    if (range.max_key - range.min_key > NARROW_WINDOW) return false;
+
+    int low = (int)range.min_key - KEY_BIAS;
+    int digits = ((int)(range.max_key - range.min_key) + PRODUCT_BITS + DIGIT_BITS - 1) / DIGIT_BITS;
+    double sigma[MAX_DIGITS], d[MAX_DIGITS] = {};
+    for (int j = 0; j < digits; j++) sigma[j] = ldexp(1.5, low + DIGIT_BITS * j + 52);
+
+    split_digits(a, b, n, digits, sigma, d);
+    for (int j = 0; j < digits; j++) acc.add(d[j]);
+    return true;
+}
+
+double narrow_dot_product(DotView a, DotView b, NarrowDotInfo& info){
+    DOT_INSTRUMENT_CALL("Narrow", a, b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    LongAccumulator acc;
+    info.blocks = 0;
+    info.fallback_blocks = 0;
+    // Данные с шагом собираются поблочно в буфер и идут в те же ядра
+    double gathered_a[NARROW_BLOCK], gathered_b[NARROW_BLOCK];
+    for (size_t begin = 0; begin < a.size; begin += NARROW_BLOCK){
+        size_t n = min(NARROW_BLOCK, a.size - begin);
+        DotView block_a = a.slice(begin, n), block_b = b.slice(begin, n);
+        const double* pa = block_a.data;
+        const double* pb = block_b.data;
+        if (!block_a.contiguous()){
+            for (size_t i = 0; i < n; i++) gathered_a[i] = block_a[i];
+            pa = gathered_a;
+        }
+        if (!block_b.contiguous()){
+            for (size_t i = 0; i < n; i++) gathered_b[i] = block_b[i];
+            pb = gathered_b;
+        }
+        info.blocks++;
+        if (add_narrow_block(acc, pa, pb, n)) continue;
+        info.fallback_blocks++;
+        acc.add(DotView(pa, n), DotView(pb, n));
+    }
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(acc.round());
+}
+
+double narrow_dot_product(DotView a, DotView b){
+    NarrowDotInfo info;
+    return narrow_dot_product(a, b, info);
+}
+
+double narrow_dot_product(const vector<double>& a, const vector<double>& b){
+    return narrow_dot_product(DotView(a), DotView(b));
+}
@@ -0,0 +1,371 @@
+#include "norm.hpp"
+#include "cpu_dispatch.hpp"
+#include "eft.hpp"
+#include "eft_simd.hpp"
+#include "instrument.hpp"
+#include "long_accumulator.hpp"
+#include "merge.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NORM_HAVE_X86 1
+#endif
+
+using namespace std;
+
+// ── Точная сумма квадратов ─────────────────────────────────────────────────
+// x = m·2^(e-1075) (для субнормалей e = 0 и вес 2^-1074), x² = m²·2^(2e-2150).
+// m² < 2^106, поэтому 2^22 слагаемых не переполняют __int128-корзину.
+class SquareBuckets {
+public:
+    void add(DotView x){
+        // Отрезки до очередного сброса: в цикле по элементам нет проверки,
+        // непрерывные данные читаются по указателю
+        size_t i = 0;
+        while (i < x.size){
+            if (pending == FLUSH_INTERVAL) flush();
+            size_t count = min<size_t>(x.size - i, FLUSH_INTERVAL - pending);
+            if (x.contiguous()){
+                const double* p = x.data + i;
+                for (size_t j = 0; j < count; j++) add_one(p[j]);
+            } else {
+                for (size_t j = 0; j < count; j++) add_one(x[i + j]);
+            }
+            pending += (uint32_t)count;
+            i += count;
+        }
+    }
+
+    // Сумма без спецзначений; их сообщают has_nan и has_inf
+    const LongAccumulator& sum(){
+        flush();
+        return acc;
+    }
+
+    bool has_nan() const { return nan_seen; }
+    bool has_inf() const { return inf_seen; }
+
+private:
+    inline void add_one(double v){
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(double));
+        uint64_t abs_bits = bits & ~SIGN_BIT;
+        int e = (int)(abs_bits >> 52);
+        if (e == 2047){                             // Inf или NaN — только флаги
+            nan_seen |= abs_bits > INF_BITS;
+            inf_seen |= abs_bits == INF_BITS;
+            return;
+        }
+        uint64_t m = (bits & FRAC_MASK) | (uint64_t)(e != 0) << 52;
+        bucket[e] += (unsigned __int128)m * m;
+    }
+
+    static const uint32_t FLUSH_INTERVAL = 1u << 22;
+    static const uint64_t SIGN_BIT = 1ULL << 63;
+    static const uint64_t FRAC_MASK = (1ULL << 52) - 1;
+    static const uint64_t INF_BITS = 0x7FFULL << 52;
+
+    void flush(){
+        for (int e = 0; e < 2047; e++){
+            if (!bucket[e]) continue;
+            acc.add_scaled(bucket[e], 2 * (e ? e - 1075 : -1074), false);
+            bucket[e] = 0;
+        }
+        pending = 0;
+    }
+
+    unsigned __int128 bucket[2047] = {};
+    uint32_t pending = 0;
+    bool nan_seen = false;
+    bool inf_seen = false;
+    LongAccumulator acc;
+};
+
+double sum_of_squares(DotView x){
+    DOT_INSTRUMENT_CALL("SumSq", x, x);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    SquareBuckets buckets;
+    buckets.add(x);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    double result;
+    if (buckets.has_nan()) result = numeric_limits<double>::quiet_NaN();
+    else if (buckets.has_inf()) result = numeric_limits<double>::infinity();
+    else result = buckets.sum().round();
+    return DOT_INSTRUMENT_RESULT(result);
+}
+
+double sum_of_squares(const vector<double>& x){
+    return sum_of_squares(DotView(x));
+}
+
+// Знак S - ((r + r⁺)/2)² для r = M·2^q: середина — (2M + 1)·2^(q-1), её
+// квадрат (2M + 1)²·2^(2q-2) целый и меньше 2^108. Ниже 2^-2148 аккумулятор
+// не хранит биты, но (2M + 1)² нечётно: отброшенные биты не нулевые, и
+// равенства нет.
+static int compare_midpoint(const LongAccumulator& s, uint64_t m, int q){
+    unsigned __int128 k = (unsigned __int128)(2 * m + 1) * (2 * m + 1);
+    int exp = 2 * q - 2;
+    bool truncated = exp < LongAccumulator::MIN_EXP;
+    if (truncated){
+        k >>= LongAccumulator::MIN_EXP - exp;
+        exp = LongAccumulator::MIN_EXP;
+    }
+    LongAccumulator d = s;
+    d.add_scaled(k, exp, true);
+    // Ненулевая разность не меньше 2^-2148: масштаб делает её нормальной
+    double sign = d.round(2400);
+    if (truncated) return sign > 0 ? 1 : -1;
+    return sign > 0 ? 1 : sign < 0 ? -1 : 0;
+}
+
+static void split_double(double r, uint64_t& m, int& q){
+    uint64_t bits;
+    memcpy(&bits, &r, sizeof(double));
+    int e = (int)(bits >> 52);
+    m = (bits & ((1ULL << 52) - 1)) | (uint64_t)(e != 0) << 52;
+    q = e ? e - 1075 : -1074;
+}
+
+// Корректно округлённый корень точной суммы: приближение через округление
+// с масштабом, затем сдвиг на соседние числа по точным сравнениям с
+// квадратами середин (не больше пары шагов)
+static double rounded_sqrt(const LongAccumulator& s){
+    double v = s.round();
+    int scale = 0;
+    if (isinf(v)) scale = -1200;
+    else if (v < 0x1p-900) scale = 1200;
+    if (scale) v = s.round(scale);
+    if (v == 0.0) return 0.0;
+    double r = min(ldexp(sqrt(v), -scale / 2), numeric_limits<double>::max());
+    for (;;){
+        if (isinf(r)) return r;
+        uint64_t m;
+        int q;
+        split_double(r, m, q);
+        // Выше середины с r⁺ (или на ней при нечётном M) — вверх
+        int upper = compare_midpoint(s, m, q);
+        if (upper > 0 || (upper == 0 && (m & 1))){
+            r = nextafter(r, numeric_limits<double>::infinity());
+            continue;
+        }
+        if (r == 0.0) return r;
+        double below = nextafter(r, 0.0);
+        split_double(below, m, q);
+        int lower = compare_midpoint(s, m, q);
+        if (lower < 0 || (lower == 0 && !(m & 1))){
+            r = below;
+            continue;
+        }
+        return r;
+    }
+}
+
+double norm2(DotView x){
+    DOT_INSTRUMENT_CALL("Norm2", x, x);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    SquareBuckets buckets;
+    buckets.add(x);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    double result;
+    if (buckets.has_nan()) result = numeric_limits<double>::quiet_NaN();
+    else if (buckets.has_inf()) result = numeric_limits<double>::infinity();
+    else result = rounded_sqrt(buckets.sum());
+    return DOT_INSTRUMENT_RESULT(result);
+}
+
+double norm2(const vector<double>& x){
+    return norm2(DotView(x));
+}
+
+// ── Компенсированная масштабированная сумма квадратов ───────────────────────
+// Классы чисел по Блю: средние, большие (x·2^-538) и малые (x·2^537).
+// После масштаба квадрат любого конечного числа не больше 2^972, поэтому
+// цепочки не переполняются, а малые числа не уходят в субнормали.
+static const double T_BIG = 0x1p486;
+static const double T_SMALL = 0x1p-511;
+static const double S_BIG = 0x1p-538;
+static const double S_SMALL = 0x1p537;
+enum { MEDIUM = 0, BIG = 1, SMALL = 2 };
+
+// Состояние: hi, lo по 3 · MERGE_LANES — класс c, цепочка k в [c·LANES + k]
+static inline void square_update(double* hi, double* lo, size_t lane, double x){
+    double ax = fabs(x);
+    int c = MEDIUM;
+    double scale = 1.0;
+    if (ax > T_BIG){ c = BIG; scale = S_BIG; }
+    else if (ax < T_SMALL && ax != 0.0){ c = SMALL; scale = S_SMALL; }
+    double v = x * scale;
+    dot2_update(hi[c * MERGE_LANES + lane], lo[c * MERGE_LANES + lane], v, v);
+}
+
+// Ядро ведёт только средние цепочки и останавливается перед первым блоком
+// из MERGE_LANES чисел, где есть большое или малое; возвращает число
+// обработанных элементов (кратно MERGE_LANES, не больше n)
+typedef size_t (*SquareKernel)(const double*, size_t, double*, double*);
+
+static size_t squares_kernel_scalar(const double*, size_t, double*, double*){
+    return 0;
+}
+
+#ifdef NORM_HAVE_X86
+__attribute__((target("avx2,fma")))
+static size_t squares_kernel_avx2(const double* x, size_t n, double* hi, double* lo){
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d big = _mm256_set1_pd(T_BIG), small = _mm256_set1_pd(T_SMALL), zero = _mm256_setzero_pd();
+    __m256d h[4], l[4];
+    for (int k = 0; k < 4; k++){
+        h[k] = _mm256_loadu_pd(hi + 4 * k);
+        l[k] = _mm256_loadu_pd(lo + 4 * k);
+    }
+    size_t i = 0;
+    for (; i + MERGE_LANES <= n; i += MERGE_LANES){
+        __m256d v[4];
+        __m256d out = zero;
+        for (int k = 0; k < 4; k++){
+            v[k] = _mm256_loadu_pd(x + i + 4 * k);
+            __m256d ax = _mm256_andnot_pd(sign, v[k]);
+            __m256d tiny = _mm256_and_pd(_mm256_cmp_pd(ax, small, _CMP_LT_OQ), _mm256_cmp_pd(ax, zero, _CMP_GT_OQ));
+            out = _mm256_or_pd(out, _mm256_or_pd(_mm256_cmp_pd(ax, big, _CMP_GT_OQ), tiny));
+        }
+        if (_mm256_movemask_pd(out)) break;
+        for (int k = 0; k < 4; k++){
+            dot2_step_avx2(h[k], l[k], v[k], v[k]);
+        }
+    }
+    for (int k = 0; k < 4; k++){
+        _mm256_storeu_pd(hi + 4 * k, h[k]);
+        _mm256_storeu_pd(lo + 4 * k, l[k]);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t squares_kernel_avx512(const double* x, size_t n, double* hi, double* lo){
+    const __m512d big = _mm512_set1_pd(T_BIG), small = _mm512_set1_pd(T_SMALL), zero = _mm512_setzero_pd();
+    __m512d h[2], l[2];
+    for (int k = 0; k < 2; k++){
+        h[k] = _mm512_loadu_pd(hi + 8 * k);
+        l[k] = _mm512_loadu_pd(lo + 8 * k);
+    }
+    size_t i = 0;
+    for (; i + MERGE_LANES <= n; i += MERGE_LANES){
+        __m512d v[2];
+        __mmask8 out = 0;
+        for (int k = 0; k < 2; k++){
+            v[k] = _mm512_loadu_pd(x + i + 8 * k);
+            __m512d ax = _mm512_abs_pd(v[k]);
+            out |= _mm512_cmp_pd_mask(ax, big, _CMP_GT_OQ)
+                 | (_mm512_cmp_pd_mask(ax, small, _CMP_LT_OQ) & _mm512_cmp_pd_mask(ax, zero, _CMP_GT_OQ));
+        }
+        if (out) break;
+        for (int k = 0; k < 2; k++){
+            dot2_step_avx512(h[k], l[k], v[k], v[k]);
+        }
+    }
+    for (int k = 0; k < 2; k++){
+        _mm512_storeu_pd(hi + 8 * k, h[k]);
+        _mm512_storeu_pd(lo + 8 * k, l[k]);
+    }
+    return i;
+}
+#endif
+
+static SquareKernel select_squares_kernel(){
+#ifdef NORM_HAVE_X86
+    switch (detect_simd_level()){
+        case SimdLevel::AVX512: return squares_kernel_avx512;
+        case SimdLevel::AVX2:   return squares_kernel_avx2;
+        default:                break;
+    }
+#endif
+    return squares_kernel_scalar;
+}
+
+// Сумма квадратов как sum · 2^exp: класс с самыми большими числами задаёт
+// масштаб, остальные приводятся к нему
+struct ScaledSum {
+    DoubleDouble sum;
+    int exp;
+};
+
+static ScaledSum squares_compensated(DotView x){
+    static const SquareKernel kernel = select_squares_kernel();
+    double hi[3 * MERGE_LANES] = {};
+    double lo[3 * MERGE_LANES] = {};
+    size_t n = x.size;
+    size_t i = 0;
+    if (x.contiguous()){
+        while (i + MERGE_LANES <= n){
+            i += kernel(x.data + i, n - i, hi, lo);
+            if (i + MERGE_LANES > n) break;
+            // Блок с большими или малыми числами — поэлементно
+            for (size_t k = 0; k < MERGE_LANES; k++) square_update(hi, lo, k, x.data[i + k]);
+            i += MERGE_LANES;
+        }
+    }
+    for (; i < n; i++) square_update(hi, lo, i % MERGE_LANES, x[i]);
+
+    // Квадраты неотрицательны, поэтому hi становится NaN только от NaN на
+    // входе, а Inf — только от Inf; lo в этих цепочках уже NaN
+    bool has_nan = false, has_inf = false;
+    for (size_t k = 0; k < 3 * MERGE_LANES; k++){
+        has_nan |= isnan(hi[k]);
+        has_inf |= isinf(hi[k]);
+    }
+    if (has_nan) return {{numeric_limits<double>::quiet_NaN(), 0.0}, 0};
+    if (has_inf) return {{numeric_limits<double>::infinity(), 0.0}, 0};
+
+    DoubleDouble medium = merge_lanes_result(hi, lo);
+    DoubleDouble big = merge_lanes_result(hi + MERGE_LANES, lo + MERGE_LANES);
+    DoubleDouble small = merge_lanes_result(hi + 2 * MERGE_LANES, lo + 2 * MERGE_LANES);
+    // S_BIG² = 2^-1076 и S_SMALL² = 2^1074 не помещаются в double — два умножения
+    if (big.hi != 0.0){
+        dod_add(big, medium.hi * S_BIG * S_BIG, medium.lo * S_BIG * S_BIG);
+        return {big, 1076};
+    }
+    if (small.hi != 0.0 && medium.hi < 0x1p-900){
+        dod_add(small, medium.hi * S_SMALL * S_SMALL, medium.lo * S_SMALL * S_SMALL);
+        return {small, -1074};
+    }
+    // Малые рядом со средними >= 2^-900 ниже 2^-122 относительно суммы
+    dod_add(medium, small.hi / S_SMALL / S_SMALL, small.lo / S_SMALL / S_SMALL);
+    return {medium, 0};
+}
+
+double sum_of_squares_compensated(DotView x){
+    DOT_INSTRUMENT_CALL("SumSq Dot2", x, x);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    ScaledSum s = squares_compensated(x);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    double result = isfinite(s.sum.hi) ? ldexp(dod_get(s.sum), s.exp) : s.sum.hi;
+    return DOT_INSTRUMENT_RESULT(result);
+}
+
+double sum_of_squares_compensated(const vector<double>& x){
+    return sum_of_squares_compensated(DotView(x));
+}
+
+// Корень double-double: один шаг Ньютона от sqrt(hi) с точным остатком
+static double sqrt_double_double(const DoubleDouble& s){
+    double r = sqrt(s.hi);
+    if (!isfinite(r) || r == 0.0) return r;
+    double e = fma(-r, r, s.hi) + s.lo;
+    return r + e / (2 * r);
+}
+
+double norm2_compensated(DotView x){
+    DOT_INSTRUMENT_CALL("Norm2 Dot2", x, x);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    ScaledSum s = squares_compensated(x);
+    DOT_INSTRUMENT_PHASE(Finalize);
+    return DOT_INSTRUMENT_RESULT(ldexp(sqrt_double_double(s.sum), s.exp / 2));
+}
+
+double norm2_compensated(const vector<double>& x){
+    return norm2_compensated(DotView(x));
+}
@@ -0,0 +1,99 @@
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static thread_local bool inside_pool = false;
+
+// Пул создаётся при первом параллельном вызове и живёт до конца программы
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t count){
+        for (size_t id = 0; id < count; id++){
+            workers.emplace_back([this, id]{ worker_loop(id); });
+        }
+    }
+
+    ~WorkerPool(){
+        {
+            lock_guard<mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    size_t size() const { return workers.size(); }
+
+    void run(size_t count, size_t helpers, const function<void(size_t)>& task){
+        lock_guard<mutex> serial(run_mutex);
+        {
+            lock_guard<mutex> lock(m);
+            job = &task;
+            job_count = count;
+            job_helpers = min(helpers, workers.size());
+            active = job_helpers;
+            next = 0;
+            generation++;
+        }
+        wake.notify_all();
+        drain();
+        unique_lock<mutex> lock(m);
+        done.wait(lock, [this]{ return active == 0; });
+        job = nullptr;
+    }
+
+private:
+    void drain(){
+        bool was_inside = inside_pool;
+        inside_pool = true;
+        for (size_t i = next++; i < job_count; i = next++) (*job)(i);
+        inside_pool = was_inside;
+    }
+
+    void worker_loop(size_t id){
+        uint64_t seen = 0;
+        for (;;){
+            unique_lock<mutex> lock(m);
+            wake.wait(lock, [&]{ return stop || (generation != seen && id < job_helpers); });
+            if (stop) return;
+            seen = generation;
+            lock.unlock();
+            drain();
+            lock.lock();
+            if (--active == 0) done.notify_all();
+        }
+    }
+
+    vector<thread> workers;
+    mutex run_mutex;                    // один параллельный вызов за раз
+    mutex m;
+    condition_variable wake, done;
+    const function<void(size_t)>* job = nullptr;
+    size_t job_count = 0;
+    size_t job_helpers = 0;
+    size_t active = 0;
+    atomic<size_t> next{0};
+    uint64_t generation = 0;
+    bool stop = false;
+};
+
+size_t default_thread_count(){
+    size_t n = thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+void parallel_for(size_t count, size_t threads, const function<void(size_t)>& task){
+    if (threads == 0) threads = default_thread_count();
+    if (threads <= 1 || count <= 1 || inside_pool){
+        for (size_t i = 0; i < count; i++) task(i);
+        return;
+    }
+    static WorkerPool pool(max<size_t>(default_thread_count(), 8) - 1);
+    pool.run(count, min(threads, count) - 1, task);
+}
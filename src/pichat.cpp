@@ -1,26 +1,88 @@
 #include "pichat.hpp"
+#include "instrument.hpp"
+#include <cmath>
 #include <vector>
 
 using namespace std;
 
-void pichat_sum(vector<double>& vec){
-    for (int i = vec.size() - 1; i > 0; i--){
+// Один проход каскада TwoSum от конца к началу по активной части vec[0..n).
+// Возвращает false, если проход ничего не изменил (неподвижная точка).
+bool pichat_sum(double* vec, size_t n){
+    bool changed = false;
+    for (size_t i = n - 1; i > 0; i--){
         double s = vec[i-1] + vec[i];          // Округлённая сумма
-        double r = (vec[i-1] - s) + vec[i];   // Точный остаток
+        double z = s - vec[i-1];
+        double r = (vec[i-1] - (s - z)) + (vec[i] - z);   // Точный остаток
+        changed |= r != vec[i];
         vec[i-1] = s;
         vec[i] = r;
     }
+    return changed;
 }
 
-double pichat_dot_product(const vector<double>& a, const vector<double>& b){
-    vector<double> products(a.size());
-    for (int i = 0; i < a.size(); i++){
-        products[i] = a[i] * b[i];
+// Нулевые остатки больше не влияют на сумму — убираем их, сохраняя порядок.
+// vec[0] (текущее приближение) остаётся на месте.
+static size_t compact_tail(double* vec, size_t n){
+    size_t active = 1;
+    for (size_t i = 1; i < n; i++){
+        vec[active] = vec[i];
+        active += vec[i] != 0.0;
+    }
+    return active;
+}
+
+// Верхняя граница |vec[1] + ... + vec[n-1]|. Четыре независимые частичные
+// суммы векторизуются; погрешность их округления покрывается множителем.
+static double tail_bound(const double* vec, size_t n){
+    double part[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 1;
+    for (; i + 4 <= n; i += 4){
+        for (int k = 0; k < 4; k++) part[k] += fabs(vec[i + k]);
+    }
+    for (; i < n; i++) part[0] += fabs(vec[i]);
+    double bound = (part[0] + part[1]) + (part[2] + part[3]);
+    return bound * (1.0 + 2.0 * (double)n * 0x1p-53);
+}
+
+double pichat_dot_product(DotView a, DotView b, DotWorkspace& workspace){
+    DOT_INSTRUMENT_CALL("Pichat", a, b);
+    size_t n = a.size;
+    if (n == 0) return DOT_INSTRUMENT_RESULT(0.0);
+    DOT_INSTRUMENT_PHASE(Products);
+    double* vec = workspace.buffer(n);
+    for (size_t i = 0; i < n; i++){
+        vec[i] = a[i] * b[i];
+    }
+
+    // Точная сумма равна vec[0] + хвост. Если ни vec[0] - B, ни vec[0] + B
+    // не округляются в другое число, то (по монотонности округления) и
+    // точная сумма округляется в vec[0] — дальнейшие проходы не нужны.
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    size_t active = n;
+    for (size_t k = 0; k + 1 < n && active > 1; k++){
+        bool changed = pichat_sum(vec, active);
+        if (!isfinite(vec[0])) return DOT_INSTRUMENT_RESULT(vec[0]);
+        active = compact_tail(vec, active);
+        double bound = tail_bound(vec, active);
+        if (vec[0] + bound == vec[0] && vec[0] - bound == vec[0]) return DOT_INSTRUMENT_RESULT(vec[0]);
+        if (!changed) break;
     }
-    
-    for (int k = 0; k < products.size() - 1; k++){
-        pichat_sum(products);
+
+    // Неподвижная точка: остатки не перекрываются, |vec[1]| <= ulp(vec[0])/2.
+    // Граница не сработала только если vec[1] — ровно половина ulp; тогда
+    // направление округления решает знак следующего остатка.
+    DOT_INSTRUMENT_PHASE(Finalize);
+    if (active > 2){
+        double next = nextafter(vec[0], vec[1] > 0 ? INFINITY : -INFINITY);
+        if (next - vec[0] == 2.0 * vec[1] && signbit(vec[2]) == signbit(vec[1])) return DOT_INSTRUMENT_RESULT(next);
     }
-    
-    return products[0];
-}
\ No newline at end of file
+    return DOT_INSTRUMENT_RESULT(vec[0]);
+}
+
+double pichat_dot_product(DotView a, DotView b){
+    return pichat_dot_product(a, b, thread_workspace());
+}
+
+double pichat_dot_product(const vector<double>& a, const vector<double>& b){
+    return pichat_dot_product(DotView(a), DotView(b), thread_workspace());
+}
@@ -0,0 +1,210 @@
+#include "prepared.hpp"
+#include "adaptive.hpp"
+#include "cpu_dispatch.hpp"
+#include "eft.hpp"
+#include "instrument.hpp"
+#include "merge.hpp"
+#include "narrow.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PREPARED_HAVE_X86 1
+#endif
+
+using namespace std;
+
+// Множитель Вельткампа 2^27 + 1: x = high + low, в каждой половине не
+// больше 26 значащих бит, и произведения половин точны
+static const double SPLITTER = 134217729.0;
+
+// Порядки и классы чисел операнда прямо из битов
+struct ExponentRange {
+    int min_exp = 1 << 20;
+    int max_exp = -(1 << 20);
+    bool nan = false;
+    bool inf = false;
+    bool subnormal = false;
+};
+
+static void scan_exponents(DotView x, ExponentRange& r){
+    for (size_t i = 0; i < x.size; i++){
+        double v = x[i];
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(double));
+        int biased = (int)(bits >> 52) & 0x7FF;
+        uint64_t mant = bits & ((1ULL << 52) - 1);
+        if (biased == 0x7FF){
+            if (mant) r.nan = true;
+            else r.inf = true;
+            continue;
+        }
+        if (biased == 0){
+            if (mant == 0) continue;
+            r.subnormal = true;
+        }
+        int e = biased ? biased - 1023 : ilogb(v);
+        r.min_exp = min(r.min_exp, e);
+        r.max_exp = max(r.max_exp, e);
+    }
+}
+
+// Путь Деккера работает только на уровне SSE2 (см. merge_prepared)
+static bool dekker_level(){
+    static const bool sse2 = detect_simd_level() == SimdLevel::SSE2;
+    return sse2;
+}
+
+PreparedVector::PreparedVector(DotView x) : values(x.size){
+    ExponentRange r;
+    scan_exponents(x, r);
+    min_exp = r.min_exp;
+    max_exp = r.max_exp;
+    nan = r.nan;
+    inf = r.inf;
+    subnormal = r.subnormal;
+    for (size_t i = 0; i < x.size; i++) values[i] = x[i];
+    if (!dekker_level() || !splittable() || subnormal) return;
+    high.resize(x.size);
+    low.resize(x.size);
+    for (size_t i = 0; i < x.size; i++){
+        double c = SPLITTER * values[i];
+        high[i] = c - (c - values[i]);
+        low[i] = values[i] - high[i];
+    }
+}
+
+// TwoProd по Деккеру с готовыми половинами a даёт ту же точную ошибку,
+// что и fma, если все ненулевые произведения лежат в [2^-970, 2^1021):
+// произведения половин не теряют бит в субнормалях, a·b не переполняется
+static bool dekker_exact(const PreparedVector& a, const ExponentRange& b){
+    if (!a.has_halves() || !a.splittable() || a.has_subnormal() || b.nan || b.inf || b.subnormal || b.max_exp >= 995) return false;
+    if (a.min_exponent() > a.max_exponent() || b.min_exp > b.max_exp) return true;     // все произведения нулевые
+    return a.min_exponent() + b.min_exp >= -970 && a.max_exponent() + b.max_exp <= 1020;
+}
+
+// Шаг цепочки Dot2 — как dot2_update, но ошибка произведения по Деккеру
+static inline void dot2_update_split(double& hi, double& lo, double a, double ah, double al, double b){
+    double p = a * b;
+    double c = SPLITTER * b;
+    double bh = c - (c - b);
+    double bl = b - bh;
+    double e = (((ah * bh - p) + ah * bl) + al * bh) + al * bl;
+    pair<double, double> sum = two_sum(hi, p);
+    hi = sum.first;
+    lo += sum.second + e;
+}
+
+// Элементы [begin, end) по цепочкам i % MERGE_LANES
+static void split_lanes_scalar(const PreparedVector& a, const double* b, size_t begin, size_t end,
+                               double* hi, double* lo){
+    const double* x = a.view().data;
+    const double* xh = a.high_part();
+    const double* xl = a.low_part();
+    for (size_t i = begin; i < end; i++){
+        size_t k = i % MERGE_LANES;
+        dot2_update_split(hi[k], lo[k], x[i], xh[i], xl[i], b[i]);
+    }
+}
+
+#ifdef PREPARED_HAVE_X86
+// Тот же порядок операций, что в merge_kernel_sse2, но без скалярных fma()
+__attribute__((target("sse2")))
+static void split_kernel_sse2(const double* x, const double* xh, const double* xl, const double* b, size_t n,
+                              double* hi, double* lo){
+    const __m128d splitter = _mm_set1_pd(SPLITTER);
+    __m128d h[8], l[8];
+    for (int k = 0; k < 8; k++){
+        h[k] = _mm_loadu_pd(hi + 2 * k);
+        l[k] = _mm_loadu_pd(lo + 2 * k);
+    }
+    for (size_t i = 0; i < n; i += MERGE_LANES){
+        for (int k = 0; k < 8; k++){
+            size_t j = i + 2 * k;
+            __m128d va = _mm_loadu_pd(x + j);
+            __m128d ah = _mm_loadu_pd(xh + j);
+            __m128d al = _mm_loadu_pd(xl + j);
+            __m128d vb = _mm_loadu_pd(b + j);
+            __m128d p = _mm_mul_pd(va, vb);
+            __m128d c = _mm_mul_pd(splitter, vb);
+            __m128d bh = _mm_sub_pd(c, _mm_sub_pd(c, vb));
+            __m128d bl = _mm_sub_pd(vb, bh);
+            __m128d e = _mm_sub_pd(_mm_mul_pd(ah, bh), p);
+            e = _mm_add_pd(e, _mm_mul_pd(ah, bl));
+            e = _mm_add_pd(e, _mm_mul_pd(al, bh));
+            e = _mm_add_pd(e, _mm_mul_pd(al, bl));
+            __m128d s = _mm_add_pd(h[k], p);
+            __m128d z = _mm_sub_pd(s, h[k]);
+            __m128d t = _mm_add_pd(_mm_sub_pd(h[k], _mm_sub_pd(s, z)), _mm_sub_pd(p, z));
+            h[k] = s;
+            l[k] = _mm_add_pd(l[k], _mm_add_pd(t, e));
+        }
+    }
+    for (int k = 0; k < 8; k++){
+        _mm_storeu_pd(hi + 2 * k, h[k]);
+        _mm_storeu_pd(lo + 2 * k, l[k]);
+    }
+}
+#endif
+
+// Непрерывная копия b в рабочей памяти потока, если у b есть шаг
+static DotView contiguous_operand(DotView b){
+    if (b.contiguous()) return b;
+    double* buffer = thread_workspace().buffer(b.size);
+    for (size_t i = 0; i < b.size; i++) buffer[i] = b[i];
+    return DotView(buffer, b.size);
+}
+
+static double merge_prepared(const PreparedVector& a, DotView b){
+    if (a.has_nan()) return numeric_limits<double>::quiet_NaN();
+    DotView cb = contiguous_operand(b);
+
+    // Уровень SSE2 означает процессор без FMA, где fma() из libm
+    // программная (сотни тактов). С AVX2 ошибка произведения — одна
+    // инструкция fmsub, а в скалярном коде fma() аппаратная — там Деккер
+    // только медленнее.
+    if (!dekker_level()) return merge_dot_product(a.view(), cb);
+    ExponentRange rb;
+    scan_exponents(cb, rb);
+    if (!dekker_exact(a, rb)) return merge_dot_product(a.view(), cb);
+
+    double hi[MERGE_LANES] = {};
+    double lo[MERGE_LANES] = {};
+    size_t n = a.size();
+    size_t body = 0;
+#ifdef PREPARED_HAVE_X86
+    body = n - n % MERGE_LANES;
+    split_kernel_sse2(a.view().data, a.high_part(), a.low_part(), cb.data, body, hi, lo);
+#endif
+    split_lanes_scalar(a, cb.data, body, n, hi, lo);
+    double result = dod_get(merge_lanes_result(hi, lo));
+    // Переполнение в цепочках — тот же пересчёт, что у merge_dot_product
+    if (!isfinite(result)) return merge_dot_product(a.view(), cb);
+    return result;
+}
+
+static double auto_prepared(const PreparedVector& a, DotView b){
+    if (a.has_nan()) return numeric_limits<double>::quiet_NaN();
+    DotView cb = contiguous_operand(b);
+    // С Inf проход Merge не даст конечной границы — сразу точный путь
+    if (a.has_inf()) return narrow_dot_product(a.view(), cb);
+    // Узкий диапазон порядков a и b сюда не ведёт: обусловленность по нему
+    // не видна, а на хорошо обусловленных данных проход Merge втрое
+    // быстрее narrow_dot_product, который auto и так берёт при отказе
+    return auto_dot_product(a.view(), cb);
+}
+
+double merge_dot_product(const PreparedVector& a, DotView b){
+    DOT_INSTRUMENT_CALL("Merge prepared", a.view(), b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    return DOT_INSTRUMENT_RESULT(merge_prepared(a, b));
+}
+
+double auto_dot_product(const PreparedVector& a, DotView b){
+    DOT_INSTRUMENT_CALL("Auto prepared", a.view(), b);
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    return DOT_INSTRUMENT_RESULT(auto_prepared(a, b));
+}
@@ -1,28 +1,57 @@
 #include "sorting.hpp"
+#include "instrument.hpp"
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <cstdint>
 
 using namespace std;
 
-// Компаратор для сортировки по убыванию экспоненты
-bool compare_by_exponent(double a, double b){
-    int exp_a, exp_b;
-    frexp(a, &exp_a);
-    frexp(b, &exp_b);
-    return exp_a > exp_b;
+static const int EXPONENT_KEYS = 2048;
+
+// Ключ сортировки — смещённая 11-битная экспонента прямо из битов числа
+static inline uint32_t exponent_key(double x){
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    return (uint32_t)(bits >> 52) & 0x7FF;
 }
 
-double sorting_dot_product(const vector<double>& a, const vector<double>& b){
-    vector<double> products(a.size());
-    for (int i = 0; i < a.size(); i++){
-        products[i] = a[i] * b[i];
+double sorting_dot_product(DotView a, DotView b, DotWorkspace& workspace){
+    DOT_INSTRUMENT_CALL("Sorting", a, b);
+    DOT_INSTRUMENT_PHASE(Products);
+    size_t n = a.size;
+
+    // Сортировка подсчётом по убыванию экспоненты за два прохода:
+    // гистограмма ключей, затем раскладка произведений в буфер
+    size_t offset[EXPONENT_KEYS] = {};
+    for (size_t i = 0; i < n; i++){
+        offset[exponent_key(a[i] * b[i])]++;
+    }
+    size_t pos = 0;
+    for (int key = EXPONENT_KEYS - 1; key >= 0; key--){
+        size_t count = offset[key];
+        offset[key] = pos;
+        pos += count;
     }
-    
-    std::sort(products.begin(), products.end(), compare_by_exponent);
-    
+
+    double* products = workspace.buffer(n);
+    for (size_t i = 0; i < n; i++){
+        double product = a[i] * b[i];
+        products[offset[exponent_key(product)]++] = product;
+    }
+
+    DOT_INSTRUMENT_PHASE(Accumulate);
     double sum = 0.0;
-    for (auto val : products) sum += val;
-    
-    return sum;
-}
\ No newline at end of file
+    for (size_t i = 0; i < n; i++) sum += products[i];
+
+    return DOT_INSTRUMENT_RESULT(sum);
+}
+
+double sorting_dot_product(DotView a, DotView b){
+    return sorting_dot_product(a, b, thread_workspace());
+}
+
+double sorting_dot_product(const vector<double>& a, const vector<double>& b){
+    return sorting_dot_product(DotView(a), DotView(b), thread_workspace());
+}
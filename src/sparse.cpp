@@ -0,0 +1,87 @@
+#include "sparse.hpp"
+#include "eft.hpp"
+#include "instrument.hpp"
+#include "kobbelt.hpp"
+#include "merge.hpp"
+#include <cmath>
+
+using namespace std;
+
+// Обход совпавших пар: visit(k, a_value, b_value), k — номер пары.
+// Для sparse·dense совпадает каждый ненулевой элемент a.
+template<class Visit>
+static void for_each_pair(SparseView a, DotView b, Visit visit){
+    for (size_t k = 0; k < a.nnz; k++){
+        visit(k, a.value[k], b[a.index[k]]);
+    }
+}
+
+template<class Visit>
+static void for_each_pair(SparseView a, SparseView b, Visit visit){
+    size_t i = 0, j = 0, k = 0;
+    while (i < a.nnz && j < b.nnz){
+        if (a.index[i] < b.index[j]) i++;
+        else if (b.index[j] < a.index[i]) j++;
+        else visit(k++, a.value[i++], b.value[j++]);
+    }
+}
+
+// Merge по совпавшим парам: пара k идёт в цепочку k % MERGE_LANES, как
+// элемент k плотного вектора в merge_dot_product, поэтому результаты совпадают
+template<class Other>
+static double merge_pairs(SparseView a, Other b){
+    double hi[MERGE_LANES] = {};
+    double lo[MERGE_LANES] = {};
+    for_each_pair(a, b, [&](size_t k, double x, double y){
+        dot2_update(hi[k % MERGE_LANES], lo[k % MERGE_LANES], x, y);
+    });
+    double result = dod_get(merge_lanes_result(hi, lo));
+    if (isfinite(result)) return result;
+
+    // Переполнение цепочки — пересчёт одной цепочкой, как в merge_dot_product
+    DoubleDouble sum{0.0, 0.0};
+    for_each_pair(a, b, [&](size_t, double x, double y){
+        pair<double, double> p = exact_multiply(x, y);
+        dod_add(sum, p.first, p.second);
+    });
+    return dod_get(sum);
+}
+
+template<class Other>
+static double kobbelt_pairs(SparseView a, Other b){
+    KobbeltAccumulator acc;
+    for_each_pair(a, b, [&](size_t, double x, double y){ acc.add_product(x, y); });
+    return acc.finalize();
+}
+
+// Произведения совпавших пар для инструментирования
+template<class Other>
+static auto pair_products(SparseView a, Other b){
+    return [=](auto record){
+        for_each_pair(a, b, [&](size_t, double x, double y){ record(x * y); });
+    };
+}
+
+double merge_dot_product(SparseView a, DotView b){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Merge sparse-dense", pair_products(a, b));
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    return DOT_INSTRUMENT_RESULT(merge_pairs(a, b));
+}
+
+double merge_dot_product(SparseView a, SparseView b){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Merge sparse-sparse", pair_products(a, b));
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    return DOT_INSTRUMENT_RESULT(merge_pairs(a, b));
+}
+
+double kobbelt_dot_product(SparseView a, DotView b){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Kobbelt sparse-dense", pair_products(a, b));
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    return DOT_INSTRUMENT_RESULT(kobbelt_pairs(a, b));
+}
+
+double kobbelt_dot_product(SparseView a, SparseView b){
+    DOT_INSTRUMENT_CALL_PRODUCTS("Kobbelt sparse-sparse", pair_products(a, b));
+    DOT_INSTRUMENT_PHASE(Accumulate);
+    return DOT_INSTRUMENT_RESULT(kobbelt_pairs(a, b));
+}
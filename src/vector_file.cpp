@@ -0,0 +1,127 @@
+#include "vector_file.hpp"
+#include "digits.hpp"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint8_t FILE_MAGIC[4] = {'D', 'O', 'T', 'V'};
+static const uint32_t FILE_VERSION = 1;
+
+// Данные отображаются как есть, поэтому нужен little-endian хост
+static bool host_little_endian(){
+    const uint16_t probe = 1;
+    uint8_t first;
+    memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+MappedVectorFile::~MappedVectorFile(){
+    close();
+}
+
+void MappedVectorFile::close(){
+    if (mapping) munmap(mapping, mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    data = nullptr;
+    row_count = column_count = 0;
+}
+
+bool MappedVectorFile::open(const string& path){
+    close();
+    if (!host_little_endian()){
+        message = "big-endian host is not supported";
+        return false;
+    }
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        message = path + ": cannot open";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < VECTOR_FILE_HEADER_SIZE){
+        ::close(fd);
+        message = path + ": not a vector file (too short)";
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);                                // отображение держит файл само
+    if (map == MAP_FAILED){
+        message = path + ": mmap failed";
+        return false;
+    }
+
+    const uint8_t* header = (const uint8_t*)map;
+    uint64_t rows = get_le(header + 8, 8);
+    uint64_t columns = get_le(header + 16, 4);
+    uint64_t offset = get_le(header + 20, 4);
+    const char* problem = nullptr;
+    if (memcmp(header, FILE_MAGIC, 4) != 0) problem = "bad magic";
+    else if (get_le(header + 4, 4) != FILE_VERSION) problem = "unsupported version";
+    else if (columns == 0) problem = "no columns";
+    else if (offset < VECTOR_FILE_HEADER_SIZE || offset % 8 != 0) problem = "bad data offset";
+    else if (offset > size) problem = "truncated data";
+    // Проверка размера без переполнения rows·columns·8
+    else if (rows > (size - offset) / 8 / columns) problem = "truncated data";
+    if (problem){
+        munmap(map, size);
+        message = path + ": " + problem;
+        return false;
+    }
+
+    mapping = map;
+    mapping_size = size;
+    data = (const double*)(header + offset);
+    row_count = (size_t)rows;
+    column_count = (size_t)columns;
+    message.clear();
+    return true;
+}
+
+DotView MappedVectorFile::column(size_t c) const {
+    if (c >= column_count) return DotView(nullptr, 0);
+    return DotView(data + c, row_count, (ptrdiff_t)column_count);
+}
+
+void MappedVectorFile::advise_sequential() const {
+    if (!mapping) return;
+    madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+    madvise(mapping, mapping_size, MADV_WILLNEED);
+}
+
+bool write_vector_file(const string& path, const vector<DotView>& columns){
+    if (columns.empty() || !host_little_endian()) return false;
+    size_t rows = columns[0].size;
+    for (const DotView& c : columns) if (c.size != rows) return false;
+
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    uint8_t header[VECTOR_FILE_HEADER_SIZE] = {};
+    memcpy(header, FILE_MAGIC, 4);
+    put_le(header + 4, FILE_VERSION, 4);
+    put_le(header + 8, rows, 8);
+    put_le(header + 16, columns.size(), 4);
+    put_le(header + 20, VECTOR_FILE_HEADER_SIZE, 4);
+    bool ok = fwrite(header, 1, sizeof(header), out) == sizeof(header);
+
+    // Строки собираются в буфер, чтобы не писать по одному числу
+    vector<double> buffer;
+    const size_t BUFFER_ROWS = 1 << 14;
+    for (size_t begin = 0; ok && begin < rows; begin += BUFFER_ROWS){
+        size_t count = min(BUFFER_ROWS, rows - begin);
+        buffer.clear();
+        for (size_t r = begin; r < begin + count; r++){
+            for (const DotView& c : columns) buffer.push_back(c[r]);
+        }
+        ok = fwrite(buffer.data(), sizeof(double), buffer.size(), out) == buffer.size();
+    }
+    ok = fclose(out) == 0 && ok;
+    return ok;
+}
@@ -1,9 +1,24 @@
+#include "adaptive.hpp"
+#include "batch.hpp"
+#include "binned.hpp"
+#include "dot_policy.hpp"
+#include "dotk.hpp"
+#include "eft.hpp"
+#include "engine.hpp"
+#include "instrument.hpp"
 #include "merge.hpp"
+#include "narrow.hpp"
+#include "norm.hpp"
 #include "fma.hpp"
+#include "gemm.hpp"
 #include "kobbelt.hpp"
+#include "low_precision.hpp"
 #include "long_accumulator.hpp"
 #include "pichat.hpp"
+#include "prepared.hpp"
 #include "sorting.hpp"
+#include "sparse.hpp"
+#include "vector_file.hpp"
 #include <gmp.h>
 #include <gmpxx.h>
 #include <iostream>
@@ -12,9 +27,16 @@
 #include <algorithm>
 #include <random>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <cfenv>
 #include <tuple>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unistd.h>
 
 void print_vector_summary(const std::vector<double>& v, const std::string& name);
 
@@ -35,45 +57,130 @@ struct AlgorithmResult{
 };
 
 // Точное скалярное произведение через GMP
-double ExactDotProductGMP(const vector<double>& a, const vector<double>& b){
-    // Проверка специальных случаев
-    bool has_nan = false;
-    int pos_infs = 0, neg_infs = 0;
-    for (int i = 0; i < a.size(); i++){
-        if (isnan(a[i]) || isnan(b[i])){
-            has_nan = true;
-            break;
+// Эталон: точная сумма в целых числах. Произведение мантисс (до 106 бит)
+// копится в __int128 корзине своей экспоненты; корзина сбрасывается в mpz
+// раньше, чем может переполниться. В конце корзины сдвигаются на свои
+// экспоненты, складываются в одно mpz и округляются к ближайшему чётному.
+// Реализация не разделяет кода с LongAccumulator.
+static const int ORACLE_MIN_EXP = -2148;                // вес младшего бита произведения
+static const int ORACLE_BUCKETS = 2 * 971 - ORACLE_MIN_EXP + 1;    // экспоненты -2148 .. 1942
+static const uint32_t ORACLE_FLUSH = 1u << 20;          // 2^20 · 2^106 < 2^127
+
+static void split_double(double x, uint64_t& mant, int& exp){
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    int biased = (int)((bits >> 52) & 0x7FF);
+    mant = bits & ((1ULL << 52) - 1);
+    if (biased == 0) exp = -1074;
+    else { mant |= 1ULL << 52; exp = biased - 1075; }
+}
+
+static void add_int128(mpz_class& z, __int128 v){
+    bool negative = v < 0;
+    unsigned __int128 m = negative ? -(unsigned __int128)v : (unsigned __int128)v;
+    mpz_class part;
+    mpz_import(part.get_mpz_t(), 1, 1, sizeof(m), 0, 0, &m);   // порядок слов хоста
+    if (negative) z -= part;
+    else z += part;
+}
+
+// Точная сумма total · 2^ORACLE_MIN_EXP. При NaN или Inf возвращает false,
+// а special — результат по IEEE
+static bool ExactDotProductSum(const vector<double>& a, const vector<double>& b, mpz_class& total, double& special){
+    bool has_nan = false, pos_inf = false, neg_inf = false;
+    vector<__int128> bucket(ORACLE_BUCKETS, 0);
+    vector<uint32_t> count(ORACLE_BUCKETS, 0);
+    vector<mpz_class> flushed(ORACLE_BUCKETS);
+
+    for (size_t i = 0; i < a.size(); i++){
+        if (!isfinite(a[i]) || !isfinite(b[i])){
+            // Спецзначения по IEEE: NaN и Inf·0 дают NaN, +Inf и -Inf вместе — NaN
+            if (isnan(a[i]) || isnan(b[i]) || a[i] == 0.0 || b[i] == 0.0) has_nan = true;
+            else if (signbit(a[i]) != signbit(b[i])) neg_inf = true;
+            else pos_inf = true;
+            continue;
+        }
+        uint64_t ma, mb;
+        int ea, eb;
+        split_double(a[i], ma, ea);
+        split_double(b[i], mb, eb);
+        if (ma == 0 || mb == 0) continue;
+        __int128 product = (__int128)((unsigned __int128)ma * mb);
+        int k = ea + eb - ORACLE_MIN_EXP;
+        bucket[k] += signbit(a[i]) != signbit(b[i]) ? -product : product;
+        if (++count[k] == ORACLE_FLUSH){
+            add_int128(flushed[k], bucket[k]);
+            bucket[k] = 0;
+            count[k] = 0;
         }
-        if (isinf(a[i])) (a[i] > 0) ? ++pos_infs : ++neg_infs;
-        if (isinf(b[i])) (b[i] > 0) ? ++pos_infs : ++neg_infs;
     }
 
-    if (has_nan) return numeric_limits<double>::quiet_NaN();
-    if (pos_infs && neg_infs) return numeric_limits<double>::quiet_NaN();
-    if (pos_infs) return numeric_limits<double>::infinity();
-    if (neg_infs) return -numeric_limits<double>::infinity();
-
-    // Точное вычисление с GMP
-    mpf_t sum, tmp_a, tmp_b, product;
-    mpf_init2(sum, 512);
-    mpf_init2(tmp_a, 512);
-    mpf_init2(tmp_b, 512);
-    mpf_init2(product, 512);
-    mpf_set_d(sum, 0.0);
+    if (has_nan || (pos_inf && neg_inf)) special = numeric_limits<double>::quiet_NaN();
+    else if (pos_inf) special = numeric_limits<double>::infinity();
+    else if (neg_inf) special = -numeric_limits<double>::infinity();
+    if (has_nan || pos_inf || neg_inf) return false;
 
-    for (int i = 0; i < a.size(); i++){
-        mpf_set_d(tmp_a, a[i]);
-        mpf_set_d(tmp_b, b[i]);
-        mpf_mul(product, tmp_a, tmp_b);  // Умножение a[i]*b[i]
-        mpf_add(sum, sum, product);      // Суммирование
+    total = 0;
+    for (int k = ORACLE_BUCKETS - 1; k >= 0; k--){
+        add_int128(flushed[k], bucket[k]);
+        if (flushed[k] != 0) total += flushed[k] << k;
     }
+    return true;
+}
+
+// Точное значение, корректно округлённое к precision битам мантиссы с
+// младшим битом не ниже 2^min_exp (53 и -1074 — double, 24 и -149 — float)
+static double ExactDotProductRounded(const vector<double>& a, const vector<double>& b, int precision, int min_exp){
+    mpz_class total;
+    double special;
+    if (!ExactDotProductSum(a, b, total, special)) return special;
+    if (total == 0) return 0.0;
+
+    // total · 2^ORACLE_MIN_EXP → precision старших бит (меньше для
+    // субнормалей), бит округления и «липкий» бит остальных
+    bool negative = total < 0;
+    mpz_class magnitude = abs(total);
+    int high = (int)mpz_sizeinbase(magnitude.get_mpz_t(), 2) - 1 + ORACLE_MIN_EXP;
+    int lsb_exp = max(high - (precision - 1), min_exp);
+    int shift = lsb_exp - ORACLE_MIN_EXP;
+    mpz_class mant = magnitude >> shift;
+    bool round_bit = mpz_tstbit(magnitude.get_mpz_t(), shift - 1) != 0;
+    bool sticky = mpz_scan1(magnitude.get_mpz_t(), 0) < (mp_bitcnt_t)(shift - 1);
+    if (round_bit && (sticky || mpz_odd_p(mant.get_mpz_t()))) mant += 1;
+    double result = ldexp(mant.get_d(), lsb_exp);
+    return negative ? -result : result;
+}
 
-    double result = mpf_get_d(sum);
-    mpf_clear(sum);
-    mpf_clear(tmp_a);
-    mpf_clear(tmp_b);
-    mpf_clear(product);
-    return result;
+double ExactDotProductGMP(const vector<double>& a, const vector<double>& b){
+    return ExactDotProductRounded(a, b, 53, -1074);
+}
+
+// Больше FLT_MAX после округления — бесконечность
+float ExactDotProductGMPFloat(const vector<double>& a, const vector<double>& b){
+    return (float)ExactDotProductRounded(a, b, 24, -149);
+}
+
+// Корректно округлённая ||x||_2: целый корень точной суммы T · 2^-2148,
+// сдвинутой на 4^k так, чтобы корень имел не меньше 56 бит; остаток корня
+// участвует в «липком» бите
+double ExactNormGMP(const vector<double>& x){
+    mpz_class total;
+    double special;
+    if (!ExactDotProductSum(x, x, total, special)) return special;
+    if (total == 0) return 0.0;
+    int bits = (int)mpz_sizeinbase(total.get_mpz_t(), 2);
+    int k = max(0, (112 - bits) / 2 + 1);
+    mpz_class scaled = total << (2 * k), root, rest;
+    mpz_sqrtrem(root.get_mpz_t(), rest.get_mpz_t(), scaled.get_mpz_t());
+    const int root_exp = ORACLE_MIN_EXP / 2 - k;                // вес младшего бита корня
+    int high = (int)mpz_sizeinbase(root.get_mpz_t(), 2) - 1 + root_exp;
+    int lsb_exp = max(high - 52, -1074);
+    int shift = lsb_exp - root_exp;                             // не меньше 1
+    mpz_class mant = root >> shift;
+    bool round_bit = mpz_tstbit(root.get_mpz_t(), shift - 1) != 0;
+    bool sticky = rest != 0 || mpz_scan1(root.get_mpz_t(), 0) < (mp_bitcnt_t)(shift - 1);
+    if (round_bit && (sticky || mpz_odd_p(mant.get_mpz_t()))) mant += 1;
+    return ldexp(mant.get_d(), lsb_exp);
 }
 
 // Проверка инвариантности к перестановкам
@@ -100,6 +207,814 @@ bool CheckPermutations(const vector<double>& a, const vector<double>& b){
     return original == permuted;
 }
 
+// Параллельный вариант с фиксированным числом потоков
+template<double ParallelFunc(const vector<double>&, const vector<double>&, size_t)>
+double WithFourThreads(const vector<double>& a, const vector<double>& b){
+    return ParallelFunc(a, b, 4);
+}
+
+// Результат параллельного варианта не должен зависеть от числа потоков
+template<double ParallelFunc(const vector<double>&, const vector<double>&, size_t)>
+bool CheckThreadCounts(const vector<double>& a, const vector<double>& b){
+    const double reference = ParallelFunc(a, b, 1);
+    for (size_t threads : {2, 3, 8}){
+        const double result = ParallelFunc(a, b, threads);
+        if (memcmp(&result, &reference, sizeof(double)) != 0) return false;
+    }
+    return true;
+}
+
+// Операнды с шагом (чередуются в одном буфере) должны давать тот же
+// результат, что и непрерывные
+template<double ViewFunc(DotView, DotView)>
+bool CheckStrided(const vector<double>& a, const vector<double>& b){
+    vector<double> interleaved(2 * a.size());
+    for (size_t i = 0; i < a.size(); i++){
+        interleaved[2 * i] = a[i];
+        interleaved[2 * i + 1] = b[i];
+    }
+    const double contiguous = ViewFunc(DotView(a), DotView(b));
+    const double strided = ViewFunc(DotView(interleaved.data(), a.size(), 2),
+                                    DotView(interleaved.data() + 1, b.size(), 2));
+    return memcmp(&contiguous, &strided, sizeof(double)) == 0;
+}
+
+// Вход тремя порциями в отдельные аккумуляторы. С roundtrip каждая часть
+// проходит serialize/deserialize и части сливаются в обратном порядке
+template<class Accumulator>
+double ChunkedSum(const vector<double>& a, const vector<double>& b, bool roundtrip){
+    const size_t parts = 3;
+    vector<Accumulator> partial(parts);
+    for (size_t p = 0; p < parts; p++){
+        size_t begin = a.size() * p / parts, end = a.size() * (p + 1) / parts;
+        partial[p].add(DotView(a).slice(begin, end - begin), DotView(b).slice(begin, end - begin));
+        if (roundtrip){
+            vector<uint8_t> bytes = partial[p].serialize();
+            if (partial[p].deserialize(bytes.data(), bytes.size() - 1)) return -1.0;   // обрезанные данные
+            bytes[0] ^= 1;
+            if (partial[p].deserialize(bytes.data(), bytes.size())) return -1.0;       // чужой формат
+            bytes[0] ^= 1;
+            partial[p] = Accumulator();
+            partial[p].deserialize(bytes.data(), bytes.size());
+        }
+    }
+    Accumulator total;
+    for (size_t p = 0; p < parts; p++) total.merge(partial[roundtrip ? parts - 1 - p : p]);
+    return total.finalize();
+}
+
+// Точные и воспроизводимые (binned) аккумуляторы дают тот же результат,
+// что и вызов на всём входе
+template<class Accumulator, double OneShot(DotView, DotView)>
+bool CheckChunkedExact(const vector<double>& a, const vector<double>& b){
+    const double chunked = ChunkedSum<Accumulator>(a, b, true);
+    const double reference = OneShot(DotView(a), DotView(b));
+    return memcmp(&chunked, &reference, sizeof(double)) == 0;
+}
+
+// Merge зависит от разбиения на порции, но не от сериализации и порядка слияния
+template<class Accumulator>
+bool CheckChunkedStable(const vector<double>& a, const vector<double>& b){
+    const double chunked = ChunkedSum<Accumulator>(a, b, true);
+    const double reference = ChunkedSum<Accumulator>(a, b, false);
+    return memcmp(&chunked, &reference, sizeof(double)) == 0;
+}
+
+// Ядро из dot_policy.hpp должно совпадать побитово с готовой функцией
+template<class Product, class Accumulator, double Reference(DotView, DotView)>
+bool CheckPolicy(const vector<double>& a, const vector<double>& b){
+    const double kernel = policy_dot_product<Product, Accumulator>(a, b);
+    const double reference = Reference(DotView(a), DotView(b));
+    return memcmp(&kernel, &reference, sizeof(double)) == 0;
+}
+
+// Элементы float: произведения точны в double, поэтому точное ядро
+// совпадает с длинным аккумулятором на тех же числах, расширенных до double
+bool CheckPolicyFloat(const vector<double>& a, const vector<double>& b){
+    vector<float> af(a.begin(), a.end()), bf(b.begin(), b.end());
+    const double kernel = policy_dot_product<FmaProduct, SuperAccumulatorSum, float>(af, bf);
+    vector<double> ad(af.begin(), af.end()), bd(bf.begin(), bf.end());
+    const double reference = long_accumulator_dot_product(ad, bd);
+    return memcmp(&kernel, &reference, sizeof(double)) == 0
+        || (std::isnan(kernel) && std::isnan(reference));
+}
+
+// Разреженные варианты должны совпадать с плотным алгоритмом на
+// совпавших парах: a хранит элементы i % 3 != 1, b — чётные
+template<double SparseDense(SparseView, DotView), double SparseSparse(SparseView, SparseView),
+         double Dense(DotView, DotView)>
+bool CheckSparse(const vector<double>& a, const vector<double>& b){
+    vector<size_t> a_index, b_index;
+    vector<double> a_value, b_value, gathered_a, gathered_b, joined_a, joined_b;
+    for (size_t i = 0; i < a.size(); i++){
+        if (i % 3 != 1){
+            a_index.push_back(i);
+            a_value.push_back(a[i]);
+            gathered_a.push_back(a[i]);
+            gathered_b.push_back(b[i]);
+        }
+        if (i % 2 == 0){
+            b_index.push_back(i);
+            b_value.push_back(b[i]);
+        }
+        if (i % 3 != 1 && i % 2 == 0){
+            joined_a.push_back(a[i]);
+            joined_b.push_back(b[i]);
+        }
+    }
+    const double sparse_dense = SparseDense(SparseView(a_index, a_value), DotView(b));
+    const double sparse_sparse = SparseSparse(SparseView(a_index, a_value), SparseView(b_index, b_value));
+    const double dense_gathered = Dense(DotView(gathered_a), DotView(gathered_b));
+    const double dense_joined = Dense(DotView(joined_a), DotView(joined_b));
+    // Индексов меньше, чем значений, — операнд не строится
+    bool rejected = false;
+    if (!a_index.empty()){
+        vector<size_t> short_index(a_index.begin(), a_index.end() - 1);
+        try { SparseView bad(short_index, a_value); } catch (const invalid_argument&){ rejected = true; }
+    }
+    return memcmp(&sparse_dense, &dense_gathered, sizeof(double)) == 0
+        && memcmp(&sparse_sparse, &dense_joined, sizeof(double)) == 0
+        && (rejected || a_index.empty());
+}
+
+// Пакетный вариант должен совпадать побитово с одиночными вызовами.
+// Пар 7 — четыре идут векторным ядром, три — хвостом; в одну пару
+// подмешаны ±1e308, чтобы проверить пересчёт при переполнении цепочки.
+template<void BatchFunc(const DotPair*, size_t, size_t, double*), double SingleFunc(DotView, DotView)>
+bool CheckBatch(size_t n){
+    const size_t count = 7;
+    mt19937_64 gen(n);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    vector<vector<double>> a(count, vector<double>(n)), b(count, vector<double>(n));
+    for (size_t k = 0; k < count; k++){
+        for (size_t i = 0; i < n; i++){
+            a[k][i] = ldexp(dist(gen), (int)(gen() % 64) - 32);
+            b[k][i] = dist(gen);
+        }
+    }
+    if (n >= 2){
+        a[1][0] = 1e308; b[1][0] = 10.0;
+        a[1][1] = -1e308; b[1][1] = 10.0;
+    }
+    vector<DotPair> pairs(count);
+    for (size_t k = 0; k < count; k++) pairs[k] = {a[k].data(), b[k].data()};
+    vector<double> out(count);
+    BatchFunc(pairs.data(), count, n, out.data());
+    for (size_t k = 0; k < count; k++){
+        double single = SingleFunc(DotView(a[k]), DotView(b[k]));
+        if (memcmp(&single, &out[k], sizeof(double)) != 0) return false;
+    }
+    return true;
+}
+
+// Вариант с длиной, известной при компиляции
+template<size_t N>
+bool CheckFixed(){
+    mt19937_64 gen(N);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    vector<double> a(N), b(N);
+    for (size_t i = 0; i < N; i++){
+        a[i] = dist(gen);
+        b[i] = ldexp(dist(gen), (int)(gen() % 64) - 32);
+    }
+    double merge_fixed = merge_dot_product_fixed<N>(a.data(), b.data());
+    double fma_fixed = fma_dot_product_fixed<N>(a.data(), b.data());
+    double merge_single = merge_dot_product(a, b);
+    double fma_single = fma_dot_product(a, b);
+    return memcmp(&merge_fixed, &merge_single, sizeof(double)) == 0
+        && memcmp(&fma_fixed, &fma_single, sizeof(double)) == 0;
+}
+
+// Файл .dotv: столбцы читаются через mmap без изменений, а обрезанный
+// файл отвергается
+bool CheckVectorFile(const vector<double>& a, const vector<double>& b){
+    char path[] = "/tmp/dot_product_testXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return false;
+    close(fd);
+    bool ok = write_vector_file(path, {DotView(a), DotView(b)});
+    {
+        MappedVectorFile file;
+        ok = ok && file.open(path) && file.rows() == a.size() && file.columns() == 2;
+        ok = ok && file.column(2).size == 0;
+        for (size_t i = 0; ok && i < a.size(); i++){
+            const double x = file.column(0)[i], y = file.column(1)[i];
+            ok = memcmp(&a[i], &x, sizeof(double)) == 0
+              && memcmp(&b[i], &y, sizeof(double)) == 0;
+        }
+        if (ok){
+            const double mapped = merge_dot_product(file.column(0), file.column(1));
+            const double reference = merge_dot_product(a, b);
+            ok = memcmp(&mapped, &reference, sizeof(double)) == 0 || (std::isnan(mapped) && std::isnan(reference));
+        }
+    }
+    // Смещение данных за концом файла
+    if (ok){
+        FILE* header = fopen(path, "r+b");
+        const uint8_t far_offset[4] = {0, 0, 0x10, 0};       // 2^20
+        ok = header && fseek(header, 20, SEEK_SET) == 0 && fwrite(far_offset, 1, 4, header) == 4;
+        if (header) ok = fclose(header) == 0 && ok;
+        MappedVectorFile file;
+        ok = ok && !file.open(path);
+    }
+    if (ok && !a.empty()){
+        ok = write_vector_file(path, {DotView(a), DotView(b)})
+          && truncate(path, VECTOR_FILE_HEADER_SIZE + 16 * a.size() - 1) == 0;
+        MappedVectorFile file;
+        ok = ok && !file.open(path);
+    }
+    unlink(path);
+    return ok;
+}
+
+static bool SameOrBothNaN(double x, double y){
+    return memcmp(&x, &y, sizeof(double)) == 0 || (std::isnan(x) && std::isnan(y));
+}
+
+// Вход, округлённый к float, и те же числа, расширенные обратно до double
+static void ToFloat(const vector<double>& a, vector<float>& af, vector<double>& widened){
+    af.assign(a.begin(), a.end());
+    widened.assign(af.begin(), af.end());
+}
+
+// float: точный путь совпадает с эталоном на расширенных числах, результат
+// float — с эталоном, округлённым сразу к float
+bool CheckFloat(const vector<double>& a, const vector<double>& b){
+    vector<float> af, bf;
+    vector<double> ad, bd;
+    ToFloat(a, af, ad);
+    ToFloat(b, bf, bd);
+    const double result = float_dot_product(af, bf);
+    const float single = float_dot_product_single(af.data(), bf.data(), af.size());
+    const float single_reference = ExactDotProductGMPFloat(ad, bd);
+    return SameOrBothNaN(result, ExactDotProductGMP(ad, bd))
+        && (memcmp(&single, &single_reference, sizeof(float)) == 0 || (std::isnan(single) && std::isnan(single_reference)));
+}
+
+// Усечение к binary16 (1 + 5 + 10 бит) без обращения к библиотеке; value —
+// закодированное число
+static uint16_t ToBinary16(double x, double& value){
+    uint16_t sign = std::signbit(x) ? 0x8000 : 0;
+    double m = fabs(x);
+    if (std::isnan(x)){ value = x; return 0x7E00; }
+    if (m >= 65536.0){ value = copysign(INFINITY, x); return sign | 0x7C00; }
+    uint16_t bits;
+    if (m < ldexp(1.0, -14)){
+        double k = floor(m / ldexp(1.0, -24));          // субнормаль: k·2^-24
+        bits = (uint16_t)k;
+        m = k * ldexp(1.0, -24);
+    } else {
+        int e = ilogb(m);
+        double k = floor(m / ldexp(1.0, e - 10));       // 1024 <= k < 2048
+        bits = (uint16_t)((e + 15) << 10 | ((int)k - 1024));
+        m = k * ldexp(1.0, e - 10);
+    }
+    value = copysign(m, x);
+    return sign | bits;
+}
+
+// bfloat16 — усечение float до старших 16 бит
+static uint16_t ToBFloat16(double x, double& value){
+    float f = (float)x;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(float));
+    if (std::isnan(f)) bits |= 1u << 22;                // NaN остаётся NaN после усечения
+    bits &= 0xFFFF0000u;
+    memcpy(&f, &bits, sizeof(float));
+    value = f;
+    return (uint16_t)(bits >> 16);
+}
+
+template<HalfFormat Format>
+bool CheckHalf(const vector<double>& a, const vector<double>& b){
+    auto encode = Format == HalfFormat::Binary16 ? ToBinary16 : ToBFloat16;
+    vector<uint16_t> ah(a.size()), bh(b.size());
+    vector<double> ad(a.size()), bd(b.size());
+    for (size_t i = 0; i < a.size(); i++){
+        ah[i] = encode(a[i], ad[i]);
+        bh[i] = encode(b[i], bd[i]);
+    }
+    const double result = half_dot_product(ah.data(), bh.data(), ah.size(), Format);
+    const float single = half_dot_product_single(ah.data(), bh.data(), ah.size(), Format);
+    const float single_reference = ExactDotProductGMPFloat(ad, bd);
+    return SameOrBothNaN(result, ExactDotProductGMP(ad, bd))
+        && (memcmp(&single, &single_reference, sizeof(float)) == 0 || (std::isnan(single) && std::isnan(single_reference)));
+}
+
+// float × double
+bool CheckMixed(const vector<double>& a, const vector<double>& b){
+    vector<float> af;
+    vector<double> ad;
+    ToFloat(a, af, ad);
+    return SameOrBothNaN(mixed_dot_product(af.data(), DotView(b)), ExactDotProductGMP(ad, b));
+}
+
+// Эталон компенсированного режима: одна цепочка dot2_update по k
+static double Dot2Chain(DotView a, DotView b){
+    double hi = 0.0, lo = 0.0;
+    for (size_t i = 0; i < a.size; i++) dot2_update(hi, lo, a[i], b[i]);
+    return hi + lo;
+}
+
+// Строки {a, b, -a}, уложенные по строкам или по столбцам
+static vector<double> StackRows(const vector<vector<double>>& lines, bool column_major){
+    const size_t n = lines[0].size(), m = lines.size();
+    vector<double> out(m * n);
+    for (size_t r = 0; r < m; r++){
+        for (size_t k = 0; k < n; k++) out[column_major ? k * m + r : r * n + k] = lines[r][k];
+    }
+    return out;
+}
+
+// GEMV: A = {a, b, -a} по строкам и по столбцам, x = b. Результат не
+// зависит от раскладки и числа потоков; Dot2 совпадает с цепочкой, точный
+// режим — с GMP
+template<GemmMode Mode>
+bool CheckGemv(const vector<double>& a, const vector<double>& b){
+    const size_t n = a.size();
+    vector<double> minus_a(n);
+    for (size_t k = 0; k < n; k++) minus_a[k] = -a[k];
+    const vector<vector<double>> lines = {a, b, minus_a};
+    vector<double> by_rows = StackRows(lines, false), by_columns = StackRows(lines, true);
+    double y[3], y_columns[6], y_threads[3];
+    gemv(MatrixView(by_rows.data(), 3, n), DotView(b), y, 1, Mode, 1);
+    gemv(MatrixView(by_columns.data(), 3, n, 1, 3), DotView(b), y_columns, 2, Mode, 1);
+    gemv(MatrixView(by_rows.data(), 3, n), DotView(b), y_threads, 1, Mode, 3);
+    bool ok = true;
+    for (size_t r = 0; r < 3; r++){
+        const double reference = Mode == GemmMode::Exact ? ExactDotProductGMP(lines[r], b)
+                                                         : Dot2Chain(DotView(lines[r]), DotView(b));
+        ok = ok && SameOrBothNaN(y[r], reference) && SameOrBothNaN(y_columns[2 * r], y[r])
+                && SameOrBothNaN(y_threads[r], y[r]);
+    }
+    return ok;
+}
+
+// GEMM: {a, b} × {b, a, -a}^T — те же проверки поэлементно; B хранится
+// транспонированной, чтобы пройти и по шагу столбцов
+template<GemmMode Mode>
+bool CheckGemm(const vector<double>& a, const vector<double>& b){
+    const size_t n = a.size();
+    vector<double> minus_a(n);
+    for (size_t k = 0; k < n; k++) minus_a[k] = -a[k];
+    const vector<vector<double>> left = {a, b}, right = {b, a, minus_a};
+    vector<double> a_rows = StackRows(left, false), b_columns = StackRows(right, false);
+    MatrixView am(a_rows.data(), 2, n), bm = MatrixView(b_columns.data(), 3, n).transposed();
+    double c[2 * 4], c_threads[2 * 3];
+    gemm(am, bm, c, 4, Mode, 1);
+    gemm(am, bm, c_threads, 3, Mode, 3);
+    bool ok = true;
+    for (size_t i = 0; i < 2; i++){
+        for (size_t j = 0; j < 3; j++){
+            const double reference = Mode == GemmMode::Exact ? ExactDotProductGMP(left[i], right[j])
+                                                             : Dot2Chain(DotView(left[i]), DotView(right[j]));
+            ok = ok && SameOrBothNaN(c[i * 4 + j], reference) && SameOrBothNaN(c_threads[i * 3 + j], reference);
+        }
+    }
+    return ok;
+}
+
+// Размеры, пересекающие границы микроблоков и блоков кэша: плохо
+// обусловленные элементы, сравнение каждого элемента C с эталоном
+bool CheckGemmBlocks(size_t m, size_t n, size_t k){
+    mt19937_64 gen(m * 1000003 + n * 1009 + k);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    vector<vector<double>> rows(m, vector<double>(k)), columns(n, vector<double>(k));
+    for (auto& row : rows) for (double& x : row) x = ldexp(dist(gen), (int)(gen() % 80) - 40);
+    for (auto& column : columns) for (double& x : column) x = ldexp(dist(gen), (int)(gen() % 80) - 40);
+    vector<double> a_data = StackRows(rows, false), b_data = StackRows(columns, false);
+    MatrixView a(a_data.data(), m, k), b = MatrixView(b_data.data(), n, k).transposed();
+    // Та же A по столбцам и с шагом 2 по обеим осям — для ядер GEMV
+    vector<double> a_columns = StackRows(rows, true), a_spread(2 * m * k);
+    for (size_t i = 0; i < m * k; i++) a_spread[2 * i] = a_data[i];
+    MatrixView a_by_columns(a_columns.data(), m, k, 1, (ptrdiff_t)m);
+    MatrixView a_strided(a_spread.data(), m, k, 2 * (ptrdiff_t)k, 2);
+    vector<double> compensated(m * n), exact(m * n), y(m), y_columns(m), y_strided(m);
+    gemm(a, b, compensated.data(), n, GemmMode::Compensated, 3);
+    gemm(a, b, exact.data(), n, GemmMode::Exact, 2);
+    gemv(a, DotView(columns[0]), y.data(), 1, GemmMode::Exact);
+    gemv(a_by_columns, DotView(columns[0]), y_columns.data(), 1, GemmMode::Compensated, 2);
+    gemv(a_strided, DotView(columns[0]), y_strided.data(), 1, GemmMode::Compensated);
+    bool ok = true;
+    for (size_t i = 0; i < m; i++){
+        for (size_t j = 0; j < n; j++){
+            ok = ok && SameOrBothNaN(compensated[i * n + j], Dot2Chain(DotView(rows[i]), DotView(columns[j])))
+                    && SameOrBothNaN(exact[i * n + j], ExactDotProductGMP(rows[i], columns[j]));
+        }
+        ok = ok && SameOrBothNaN(y[i], exact[i * n]) && SameOrBothNaN(y_columns[i], compensated[i * n])
+                && SameOrBothNaN(y_strided[i], compensated[i * n]);
+    }
+    return ok;
+}
+
+// Граница ошибки DotK: (u + 2γ²)|a·b| + γ^K·sum|a_i·b_i|, γ = γ_{4n-2}, плюс
+// запас на потерянные в субнормалях ошибки произведений. Ошибка
+// res - a·b считается точно: GMP по векторам, дополненным парой (res, -1).
+template<int K>
+static bool DotKWithinBound(const vector<double>& a, const vector<double>& b, double res){
+    const double u = ldexp(1.0, -53);
+    const double m = 4.0 * a.size();
+    if (m * u >= 0.5) return true;
+    const double gamma = m * u / (1 - m * u);
+    double abs_sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) abs_sum += fabs(a[i] * b[i]);
+    const double exact = ExactDotProductGMP(a, b);
+    if (!std::isfinite(abs_sum) || !std::isfinite(exact) || !std::isfinite(res))
+        return SameOrBothNaN(res, exact) || !std::isfinite(abs_sum);
+    vector<double> ae(a), be(b);
+    ae.push_back(res);
+    be.push_back(-1.0);
+    const double error = fabs(ExactDotProductGMP(ae, be));
+    const double bound = (u + 2 * gamma * gamma) * fabs(exact) + pow(gamma, K) * abs_sum
+                       + (a.size() + 1) * ldexp(1.0, -1074);
+    return error <= bound * (1 + 4 * u);
+}
+
+// DotK: граница ошибки, совпадение вариантов с K при компиляции и во время
+// выполнения, совпадение SIMD-пути с путём по шагу
+template<int K>
+bool CheckDotK(const vector<double>& a, const vector<double>& b){
+    const double res = dotk_dot_product<K>(DotView(a), DotView(b));
+    const double runtime = dotk_dot_product(a, b, K);
+    vector<double> a2(2 * a.size()), b2(2 * b.size());
+    for (size_t i = 0; i < a.size(); i++){ a2[2 * i] = a[i]; b2[2 * i] = b[i]; }
+    const double strided = dotk_dot_product<K>(DotView(a2.data(), a.size(), 2), DotView(b2.data(), b.size(), 2));
+    return SameOrBothNaN(res, runtime) && SameOrBothNaN(res, strided) && DotKWithinBound<K>(a, b, res);
+}
+
+// Плохо обусловленные суммы по образцу GenDot: к случайным произведениям
+// с широким разбросом экспонент levels раз дописывается пара
+// (-fl(точная сумма), 1), и каждая такая пара гасит ещё около 53 бит
+static void MakeIllConditioned(size_t n, int levels, mt19937_64& gen, vector<double>& a, vector<double>& b){
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    a.clear();
+    b.clear();
+    for (size_t i = 0; i < n; i++){
+        a.push_back(ldexp(dist(gen), (int)(gen() % 201) - 100));
+        b.push_back(dist(gen));
+    }
+    for (int level = 0; level < levels; level++){
+        const double sum = ExactDotProductGMP(a, b);
+        if (sum == 0.0) break;
+        a.push_back(-sum);
+        b.push_back(1.0);
+    }
+    vector<size_t> order(a.size());
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), gen);
+    vector<double> as(a.size()), bs(b.size());
+    for (size_t i = 0; i < order.size(); i++){ as[i] = a[order[i]]; bs[i] = b[order[i]]; }
+    a.swap(as);
+    b.swap(bs);
+}
+
+// Граница ошибки DotK на обусловленности вплоть до 2^(53·K)
+template<int K>
+bool CheckDotKConditioned(size_t n){
+    mt19937_64 gen(n * 31 + K);
+    vector<double> a, b;
+    bool ok = true;
+    for (int levels = 1; levels <= K; levels++){
+        MakeIllConditioned(n, levels, gen, a, b);
+        ok = ok && DotKWithinBound<K>(a, b, dotk_dot_product<K>(DotView(a), DotView(b)));
+    }
+    return ok;
+}
+
+// Нормы по a и по b: точные — побитово с GMP, компенсированные — в пределах
+// границы; путь с шагом 2 совпадает с SIMD-путём
+static bool CheckNormsOf(const vector<double>& x){
+    const double u = ldexp(1.0, -53);
+    vector<double> x2(2 * x.size());
+    for (size_t i = 0; i < x.size(); i++) x2[2 * i] = x[i];
+    DotView strided(x2.data(), x.size(), 2);
+
+    const double squares = ExactDotProductGMP(x, x), norm = ExactNormGMP(x);
+    const double squares_dot2 = sum_of_squares_compensated(x), norm_dot2 = norm2_compensated(x);
+    bool ok = SameOrBothNaN(sum_of_squares(x), squares) && SameOrBothNaN(sum_of_squares(strided), squares)
+           && SameOrBothNaN(norm2(x), norm) && SameOrBothNaN(norm2(strided), norm)
+           && SameOrBothNaN(sum_of_squares_compensated(strided), squares_dot2)
+           && SameOrBothNaN(norm2_compensated(strided), norm_dot2);
+    // Квадраты ниже 2^-1074 (и ошибки их TwoProd) теряются только в
+    // компенсированной сумме без масштаба
+    const double slack = x.size() * ldexp(1.0, -1073);
+    if (std::isfinite(squares))
+        ok = ok && fabs(squares_dot2 - squares) <= 4 * u * squares + slack;
+    else
+        ok = ok && SameOrBothNaN(squares_dot2, squares);
+    if (std::isfinite(norm))
+        ok = ok && fabs(norm_dot2 - norm) <= 4 * u * norm;
+    else
+        ok = ok && SameOrBothNaN(norm_dot2, norm);
+    return ok;
+}
+
+bool CheckNorms(const vector<double>& a, const vector<double>& b){
+    return CheckNormsOf(a) && CheckNormsOf(b);
+}
+
+// Края диапазона: только большие (сумма квадратов переполняется, норма
+// нет), только субнормали, смесь всех классов, пифагоровы тройки
+bool CheckNormRanges(){
+    mt19937_64 gen(2148);
+    uniform_real_distribution<double> dist(0.5, 1.0);
+    vector<vector<double>> inputs;
+    for (size_t n : {1, 5, 16, 37, 1000}){
+        vector<double> huge(n), tiny(n), mixed(n), medium(n);
+        for (size_t i = 0; i < n; i++){
+            huge[i] = ldexp(dist(gen), 1000 + (int)(gen() % 24));
+            tiny[i] = ldexp(dist(gen), -1074 + (int)(gen() % 60));
+            mixed[i] = ldexp(dist(gen), (int)(gen() % 2098) - 1074) * (gen() % 2 ? 1 : -1);
+            medium[i] = ldexp(dist(gen), (int)(gen() % 200) - 100);
+        }
+        // Одно большое или малое число посреди средних
+        vector<double> one_big = medium, one_small = medium;
+        one_big[n / 2] = 0x1p700;
+        one_small[n / 2] = 0x1p-700;
+        inputs.insert(inputs.end(), {huge, tiny, mixed, medium, one_big, one_small});
+    }
+    for (int e : {-1074, -600, 0, 600, 1020}){
+        inputs.push_back({ldexp(3.0, e), ldexp(4.0, e)});
+        inputs.push_back({ldexp(5.0, e), 0.0, ldexp(-12.0, e)});
+    }
+    bool ok = true;
+    for (const vector<double>& x : inputs) ok = ok && CheckNormsOf(x);
+
+    // 2^24 бесконечностей: флаг Inf не должен зависеть от их числа
+    const double inf = numeric_limits<double>::infinity();
+    DotView infs(&inf, (size_t)1 << 24, 0);
+    ok = ok && sum_of_squares(infs) == inf && norm2(infs) == inf;
+
+    // Тройки a = m² - n², b = 2mn, c = m² + n² при n = m - d, d нечётно:
+    // c нечётно и лежит в [2^53, 2^54), где шаг double — 2, то есть норма
+    // ровно посередине между c - 1 и c + 1 и округляется к чётной мантиссе
+    for (int t = 0; t < 20 && ok; t++){
+        const int64_t m = 67108864 + 100 + (int64_t)(gen() % 27797000);
+        const int64_t d = 2 * (int64_t)(gen() % 50) + 1, n = m - d;
+        const int64_t c = m * m + n * n;
+        const double tie = (double)((c + 1) % 4 == 0 ? c + 1 : c - 1);
+        for (int e : {-1000, 0, 900}){
+            vector<double> x = {ldexp((double)(m * m - n * n), e), ldexp((double)(2 * m * n), e)};
+            const double r = norm2(x);
+            ok = ok && r == ldexp(tie, e) && CheckNormsOf(x);
+        }
+    }
+    return ok;
+}
+
+// Узкий путь: результат побитово равен GMP, а число блоков, ушедших в
+// длинный аккумулятор, — ровно ожидаемое
+static bool NarrowMatches(const vector<double>& a, const vector<double>& b, size_t fallback_blocks){
+    NarrowDotInfo info;
+    const double r = narrow_dot_product(DotView(a), DotView(b), info);
+    return SameOrBothNaN(r, ExactDotProductGMP(a, b)) && info.fallback_blocks == fallback_blocks;
+}
+
+// Окно экспонент: ширина до NARROW_WINDOW и длины вокруг границ блока и
+// SIMD-ядра без откатов (в том числе с шагом 2); плохая обусловленность;
+// спецзначения, субнормали и края диапазона уходят в длинный аккумулятор
+// только в своём блоке
+bool CheckNarrowWindow(){
+    mt19937_64 gen(NARROW_BLOCK);
+    uniform_real_distribution<double> dist(0.5, 1.0);
+    auto random_vector = [&](size_t n, int low, int span){
+        vector<double> v(n);
+        for (size_t i = 0; i < n; i++)
+            v[i] = ldexp(dist(gen), low + (int)(gen() % (span + 1))) * (gen() % 2 ? 1 : -1);
+        return v;
+    };
+    bool ok = true;
+    for (int span : {0, 10, 30, 60}){
+        for (size_t n : {1, 15, 16, 1000, 1024, 1025, 5000}){
+            const int low = (int)(gen() % 400) - 200;
+            vector<double> a = random_vector(n, low, span), b = random_vector(n, -low, span);
+            ok = ok && NarrowMatches(a, b, 0);
+
+            vector<double> a2(2 * n), b2(2 * n);
+            for (size_t i = 0; i < n; i++){ a2[2 * i] = a[i]; b2[2 * i] = b[i]; }
+            NarrowDotInfo info;
+            const double r = narrow_dot_product(DotView(a2.data(), n, 2), DotView(b2.data(), n, 2), info);
+            ok = ok && r == narrow_dot_product(a, b) && info.fallback_blocks == 0;
+        }
+    }
+
+    // Почти полное сокращение: a·b и -a·b', где b' отличается на ulp
+    for (size_t n : {16, 3000}){
+        vector<double> a = random_vector(n, -10, 20), b = random_vector(n, -10, 20);
+        vector<double> x = a, y = b;
+        for (size_t i = 0; i < n; i++){
+            x.push_back(-a[i]);
+            y.push_back(nextafter(b[i], gen() % 2 ? 0.0 : 2 * b[i]));
+        }
+        ok = ok && NarrowMatches(x, y, 0);
+    }
+
+    // В середине второго блока — одно «чужое» значение
+    const size_t n = 3 * NARROW_BLOCK;
+    for (double odd : {1e300, numeric_limits<double>::infinity(), numeric_limits<double>::quiet_NaN(), 0x1p-1070, 0x1p-530, 0x1p480, 0x1p200}){
+        vector<double> a = random_vector(n, -5, 10), b = random_vector(n, -5, 10);
+        a[NARROW_BLOCK + 7] = odd;
+        ok = ok && NarrowMatches(a, b, 1);
+    }
+    ok = ok && NarrowMatches(vector<double>(n, 0.0), random_vector(n, -5, 10), 0);
+    return ok;
+}
+
+// Подготовленный a: побитово как обычный вызов, в том числе для a,
+// взятого с шагом, и b, переданного с шагом
+template<double (*Prepared)(const PreparedVector&, DotView), double (*Plain)(DotView, DotView)>
+bool CheckPrepared(const vector<double>& a, const vector<double>& b){
+    size_t n = a.size();
+    vector<double> a2(2 * n), b3(3 * n);
+    for (size_t i = 0; i < n; i++){ a2[2 * i] = a[i]; b3[3 * i] = b[i]; }
+    PreparedVector pa(a), pa_strided(DotView(a2.data(), n, 2));
+    const double expected = Plain(DotView(a), DotView(b));
+    return SameOrBothNaN(Prepared(pa, DotView(b)), expected)
+        && SameOrBothNaN(Prepared(pa_strided, DotView(b3.data(), n, 3)), expected)
+        && SameOrBothNaN(Prepared(pa, DotView(b3.data(), n, 3)), expected);
+}
+
+// Сводка PreparedVector и границы, где TwoProd по Деккеру ещё точен:
+// суммы порядков около -970 и 1020, |x| около 2^995, субнормали
+bool CheckPreparedRanges(){
+    PreparedVector summary(vector<double>{0.0, -0.75, 3.0, 0x1p-1070, 8.5});
+    bool ok = summary.min_exponent() == -1070 && summary.max_exponent() == 3 && summary.has_subnormal()
+           && !summary.has_nan() && !summary.has_inf() && summary.splittable();
+    PreparedVector zeros(vector<double>(5, 0.0));
+    ok = ok && zeros.min_exponent() > zeros.max_exponent() && zeros.splittable();
+
+    mt19937_64 gen(970);
+    uniform_real_distribution<double> dist(0.5, 1.0);
+    auto random_vector = [&](size_t n, int low, int high){
+        vector<double> v(n);
+        for (size_t i = 0; i < n; i++)
+            v[i] = ldexp(dist(gen), low + (int)(gen() % (high - low + 1))) * (gen() % 2 ? 1 : -1);
+        return v;
+    };
+    const int ranges[][4] = {
+        {-486, -480, -486, -480}, {-487, -480, -486, -480}, {-10, 10, -10, 10},
+        {505, 510, 505, 510}, {505, 511, 505, 511}, {990, 994, -30, 20}, {993, 996, -30, 0},
+        {-1074, -1030, 60, 100}, {-20, 20, -1070, -1060}, {-600, 600, -600, 600}
+    };
+    for (const auto& r : ranges){
+        for (size_t n : {1, 17, 1000}){
+            vector<double> a = random_vector(n, r[0], r[1]), b = random_vector(n, r[2], r[3]);
+            PreparedVector pa(a);
+            ok = ok && SameOrBothNaN(merge_dot_product(pa, DotView(b)), merge_dot_product(a, b))
+                    && SameOrBothNaN(auto_dot_product(pa, DotView(b)), auto_dot_product(a, b));
+        }
+    }
+
+    // Пары (x, y) и (-p·2^-e, 2^e), p = fl(x·y): произведения гасятся, и
+    // результат — сумма ошибок TwoProd, где видна любая неточность Деккера
+    for (int t = 0; t < 8; t++){
+        for (int sum : {-1040, -1000, -975, -970, 0, 1000, 1019}){
+            vector<double> a, b;
+            for (int k = 0; k < 16; k++){
+                int ex = sum / 2, ey = sum - ex;
+                double x = ldexp(dist(gen), ex), y = ldexp(dist(gen), ey);
+                a.push_back(x);
+                b.push_back(y);
+                a.push_back(-ldexp(x * y, -ey));
+                b.push_back(ldexp(1.0, ey));
+            }
+            PreparedVector pa(a);
+            ok = ok && SameOrBothNaN(merge_dot_product(pa, DotView(b)), merge_dot_product(a, b));
+        }
+    }
+    return ok;
+}
+
+// Что должен вернуть движок: блокирующий вызов, а для разделённых заявок
+// Merge и FMA — точная сумма частичных сумм блоков PARALLEL_BLOCK
+static double EngineReference(DotView a, DotView b, DotAlgorithm algorithm){
+    bool split = a.size >= ENGINE_SPLIT;
+    switch (algorithm){
+        case DotAlgorithm::Fma: {
+            if (!split) return fma_dot_product(a, b);
+            LongAccumulator acc;
+            for (size_t begin = 0; begin < a.size; begin += PARALLEL_BLOCK){
+                size_t count = min(a.size - begin, PARALLEL_BLOCK);
+                acc.add(fma_dot_product(a.slice(begin, count), b.slice(begin, count)));
+            }
+            return acc.round();
+        }
+        case DotAlgorithm::Merge:
+            return split ? merge_dot_product_parallel(a, b, 1) : merge_dot_product(a, b);
+        case DotAlgorithm::Kobbelt:
+            return kobbelt_dot_product(a, b);
+        default:
+            return long_accumulator_dot_product(a, b);
+    }
+}
+
+// Асинхронный движок: несколько отправителей одновременно, заявки всех
+// алгоритмов и длин (короткие одинаковые — в пакеты, длинные — на блоки,
+// с шагом 2 и со спецзначениями); future и callback; все заявки
+// завершены, результаты побитово равны эталону
+bool CheckEngine(){
+    const size_t n = 3 * ENGINE_SPLIT + 17;
+    mt19937_64 gen(ENGINE_QUEUE_SIZE);
+    uniform_real_distribution<double> dist(0.5, 1.0);
+    vector<double> a(n), b(n), special_a(n), special_b(n);
+    for (size_t i = 0; i < n; i++){
+        a[i] = ldexp(dist(gen), (int)(gen() % 60) - 30) * (gen() % 2 ? 1 : -1);
+        b[i] = ldexp(dist(gen), (int)(gen() % 60) - 30);
+    }
+    special_a = a;
+    special_b = b;
+    special_a[5] = numeric_limits<double>::infinity();
+    special_b[n - 3] = numeric_limits<double>::quiet_NaN();
+    // Почти полное сокращение: граница Merge не помогает, Exact идёт точным проходом
+    vector<double> cancel_a(a.begin(), a.begin() + ENGINE_SPLIT), cancel_b(b.begin(), b.begin() + ENGINE_SPLIT);
+    for (size_t i = 0; i < ENGINE_SPLIT; i++){
+        cancel_a.push_back(-a[i]);
+        cancel_b.push_back(nextafter(b[i], gen() % 2 ? 0.0 : 1.0));
+    }
+
+    struct Request { DotView a, b; DotAlgorithm algorithm; };
+    vector<Request> requests;
+    const DotAlgorithm algorithms[] = {DotAlgorithm::Fma, DotAlgorithm::Merge, DotAlgorithm::Kobbelt, DotAlgorithm::Exact};
+    for (int round = 0; round < 40; round++){
+        for (DotAlgorithm algorithm : algorithms){
+            for (size_t len : {1, 8, 16, 21, 64, 200, 256}){
+                size_t offset = gen() % 1000;
+                requests.push_back({DotView(a.data() + offset, len), DotView(b.data() + offset, len), algorithm});
+            }
+            requests.push_back({DotView(a.data(), 7, 2), DotView(b.data() + 1, 7, 3), algorithm});
+            requests.push_back({DotView(special_a.data(), 40), DotView(special_b.data(), 40), algorithm});
+            if (round % 10 == 0){
+                requests.push_back({DotView(a.data(), 5000 + round), DotView(b.data(), 5000 + round), algorithm});
+                requests.push_back({DotView(a.data() + round, n - round), DotView(b.data(), n - round), algorithm});
+                requests.push_back({DotView(a.data(), n / 2, 2), DotView(b.data(), n / 2, 2), algorithm});
+                requests.push_back({DotView(special_a), DotView(special_b), algorithm});
+                requests.push_back({DotView(cancel_a), DotView(cancel_b), algorithm});
+            }
+        }
+    }
+    shuffle(requests.begin(), requests.end(), gen);
+
+    vector<double> results(requests.size());
+    atomic<size_t> callbacks{0};
+    DotEngineStats stats;
+    {
+        DotEngine engine(4);
+        const size_t producers = 4;
+        vector<thread> threads;
+        for (size_t p = 0; p < producers; p++){
+            threads.emplace_back([&, p]{
+                vector<pair<size_t, future<double>>> pending;
+                for (size_t k = p; k < requests.size(); k += producers){
+                    const Request& r = requests[k];
+                    if (k % 3 == 0){
+                        engine.submit(r.a, r.b, r.algorithm, [&results, &callbacks, k](double x){
+                            results[k] = x;
+                            callbacks++;
+                        });
+                    } else {
+                        pending.emplace_back(k, engine.submit(r.a, r.b, r.algorithm));
+                    }
+                }
+                for (auto& f : pending) results[f.first] = f.second.get();
+            });
+        }
+        for (auto& th : threads) th.join();
+        // Деструктор дожидается оставшихся callback
+    }
+    bool ok = callbacks == (requests.size() + 2) / 3;
+
+    // Счётчики — у нового движка после одного прогона, чтобы не гадать о
+    // порядке callback и инкремента
+    {
+        DotEngine engine(2);
+        vector<future<double>> pending;
+        for (const Request& r : requests) pending.push_back(engine.submit(r.a, r.b, r.algorithm));
+        for (size_t k = 0; k < requests.size(); k++){
+            double x = pending[k].get();
+            ok = ok && SameOrBothNaN(x, results[k]);
+        }
+        stats = engine.stats();
+    }
+    for (size_t k = 0; k < requests.size(); k++){
+        const Request& r = requests[k];
+        ok = ok && SameOrBothNaN(results[k], EngineReference(r.a, r.b, r.algorithm));
+    }
+    return ok && stats.submitted == requests.size() && stats.split > 0;
+}
+
+// Независимые проверки выполняются на всех ядрах; печать потом идёт по порядку
+static void RunConcurrently(const vector<function<void()>>& tasks){
+    atomic<size_t> next{0};
+    auto worker = [&]{
+        for (size_t i = next++; i < tasks.size(); i = next++) tasks[i]();
+    };
+    size_t count = max<size_t>(1, thread::hardware_concurrency());
+    vector<thread> threads;
+    for (size_t k = 1; k < count; k++) threads.emplace_back(worker);
+    worker();
+    for (auto& th : threads) th.join();
+}
+
 void print_vector_summary(const std::vector<double>& v, const std::string& name)
 {
     using std::cout;
@@ -288,11 +1203,158 @@ int main() {
     vector<tuple<string, double(*)(const vector<double>&, const vector<double>&), bool(*)(const vector<double>&, const vector<double>&)>> algorithms = {
         {"Merge", merge_dot_product, CheckPermutations<merge_dot_product>},
         {"FMA", fma_dot_product, CheckPermutations<fma_dot_product>},
-        //{"Kobbelt", kobbelt_dot_product, CheckPermutations<kobbelt_dot_product>},
+        {"Kobbelt", kobbelt_dot_product, CheckPermutations<kobbelt_dot_product>},
         {"Long Acc", long_accumulator_dot_product, CheckPermutations<long_accumulator_dot_product>},
-        //{"Pichat", pichat_dot_product, CheckPermutations<pichat_dot_product>},
-        {"Sorting", sorting_dot_product, CheckPermutations<sorting_dot_product>}
+        {"Pichat", pichat_dot_product, CheckPermutations<pichat_dot_product>},
+        {"Sorting", sorting_dot_product, CheckPermutations<sorting_dot_product>},
+        {"Auto", auto_dot_product, CheckPermutations<auto_dot_product>},
+        {"Binned", binned_dot_product, CheckPermutations<binned_dot_product>},
+        {"Narrow", narrow_dot_product, CheckPermutations<narrow_dot_product>},
+        {"Merge MT", WithFourThreads<merge_dot_product_parallel>, CheckPermutations<WithFourThreads<merge_dot_product_parallel>>},
+        {"Kobbelt MT", WithFourThreads<kobbelt_dot_product_parallel>, CheckPermutations<WithFourThreads<kobbelt_dot_product_parallel>>},
+        {"Long MT", WithFourThreads<long_accumulator_dot_product_parallel>, CheckPermutations<WithFourThreads<long_accumulator_dot_product_parallel>>},
+        {"Binned MT", WithFourThreads<binned_dot_product_parallel>, CheckPermutations<WithFourThreads<binned_dot_product_parallel>>}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> parallel_algorithms = {
+        {"Merge", CheckThreadCounts<merge_dot_product_parallel>},
+        {"Kobbelt", CheckThreadCounts<kobbelt_dot_product_parallel>},
+        {"Long Acc", CheckThreadCounts<long_accumulator_dot_product_parallel>},
+        {"Binned", CheckThreadCounts<binned_dot_product_parallel>}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> strided_algorithms = {
+        {"Merge", CheckStrided<merge_dot_product>},
+        {"FMA", CheckStrided<fma_dot_product>},
+        {"Kobbelt", CheckStrided<kobbelt_dot_product>},
+        {"Long Acc", CheckStrided<long_accumulator_dot_product>},
+        {"Pichat", CheckStrided<pichat_dot_product>},
+        {"Sorting", CheckStrided<sorting_dot_product>},
+        {"Auto", CheckStrided<auto_dot_product>},
+        {"Binned", CheckStrided<binned_dot_product>},
+        {"Narrow", CheckStrided<narrow_dot_product>}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> chunked_algorithms = {
+        {"Merge", CheckChunkedStable<MergeAccumulator>},
+        {"Kobbelt", CheckChunkedExact<KobbeltAccumulator, kobbelt_dot_product>},
+        {"Long Acc", CheckChunkedExact<LongAccumulator, long_accumulator_dot_product>},
+        {"Binned", CheckChunkedExact<BinnedAccumulator, binned_dot_product>}
+    };
+
+    /* ── ВЫЧИСЛЕНИЯ: каждая проверка каждого теста — отдельная задача ───────── */
+    struct TestOutcome {
+        double exact;
+        vector<double> results;
+        vector<char> perm_ok, threads_ok, strided_ok, chunked_ok, policy_ok, sparse_ok, low_precision_ok, matrix_ok, dotk_ok, norm_ok, prepared_ok;
     };
+    vector<TestOutcome> outcomes(tests.size());
+    vector<function<void()>> tasks;
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> policy_algorithms = {
+        {"FMA", CheckPolicy<FmaProduct, NaiveSum, fma_dot_product>},
+        {"Kobbelt", CheckPolicy<FmaProduct, BucketedSum, kobbelt_dot_product>},
+        {"Long Acc", CheckPolicy<FmaProduct, SuperAccumulatorSum, long_accumulator_dot_product>},
+        {"float", CheckPolicyFloat}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> low_precision_algorithms = {
+        {"float", CheckFloat},
+        {"fp16", CheckHalf<HalfFormat::Binary16>},
+        {"bf16", CheckHalf<HalfFormat::BFloat16>},
+        {"float×double", CheckMixed}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> prepared_algorithms = {
+        {"Merge", CheckPrepared<merge_dot_product, merge_dot_product>},
+        {"Auto", CheckPrepared<auto_dot_product, auto_dot_product>}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> norm_algorithms = {
+        {"a, b", CheckNorms}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> dotk_algorithms = {
+        {"2", CheckDotK<2>}, {"3", CheckDotK<3>}, {"4", CheckDotK<4>}, {"5", CheckDotK<5>},
+        {"6", CheckDotK<6>}, {"7", CheckDotK<7>}, {"8", CheckDotK<8>}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> matrix_algorithms = {
+        {"GEMV Dot2", CheckGemv<GemmMode::Compensated>},
+        {"GEMV точно", CheckGemv<GemmMode::Exact>},
+        {"GEMM Dot2", CheckGemm<GemmMode::Compensated>},
+        {"GEMM точно", CheckGemm<GemmMode::Exact>}
+    };
+
+    vector<pair<string, bool(*)(const vector<double>&, const vector<double>&)>> sparse_algorithms = {
+        {"Merge", CheckSparse<merge_dot_product, merge_dot_product, merge_dot_product>},
+        {"Kobbelt", CheckSparse<kobbelt_dot_product, kobbelt_dot_product, kobbelt_dot_product>}
+    };
+
+    for (size_t t = 0; t < tests.size(); ++t) {
+        const TestCase* test = &tests[t];
+        TestOutcome* out = &outcomes[t];
+        out->results.resize(algorithms.size());
+        out->perm_ok.resize(algorithms.size());
+        out->threads_ok.resize(parallel_algorithms.size());
+        out->strided_ok.resize(strided_algorithms.size());
+        out->chunked_ok.resize(chunked_algorithms.size());
+        out->policy_ok.resize(policy_algorithms.size());
+        out->sparse_ok.resize(sparse_algorithms.size());
+        out->low_precision_ok.resize(low_precision_algorithms.size());
+        out->matrix_ok.resize(matrix_algorithms.size());
+        out->dotk_ok.resize(dotk_algorithms.size());
+        out->norm_ok.resize(norm_algorithms.size());
+        out->prepared_ok.resize(prepared_algorithms.size());
+
+        tasks.push_back([=]{ out->exact = ExactDotProductGMP(test->a, test->b); });
+        for (size_t k = 0; k < algorithms.size(); ++k) {
+            auto run = std::get<1>(algorithms[k]);
+            auto perm = std::get<2>(algorithms[k]);
+            tasks.push_back([=]{ out->results[k] = run(test->a, test->b); });
+            tasks.push_back([=]{ out->perm_ok[k] = perm(test->a, test->b); });
+        }
+        for (size_t k = 0; k < parallel_algorithms.size(); ++k) {
+            auto check = parallel_algorithms[k].second;
+            tasks.push_back([=]{ out->threads_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < strided_algorithms.size(); ++k) {
+            auto check = strided_algorithms[k].second;
+            tasks.push_back([=]{ out->strided_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < chunked_algorithms.size(); ++k) {
+            auto check = chunked_algorithms[k].second;
+            tasks.push_back([=]{ out->chunked_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < policy_algorithms.size(); ++k) {
+            auto check = policy_algorithms[k].second;
+            tasks.push_back([=]{ out->policy_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < sparse_algorithms.size(); ++k) {
+            auto check = sparse_algorithms[k].second;
+            tasks.push_back([=]{ out->sparse_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < low_precision_algorithms.size(); ++k) {
+            auto check = low_precision_algorithms[k].second;
+            tasks.push_back([=]{ out->low_precision_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < matrix_algorithms.size(); ++k) {
+            auto check = matrix_algorithms[k].second;
+            tasks.push_back([=]{ out->matrix_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < dotk_algorithms.size(); ++k) {
+            auto check = dotk_algorithms[k].second;
+            tasks.push_back([=]{ out->dotk_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < norm_algorithms.size(); ++k) {
+            auto check = norm_algorithms[k].second;
+            tasks.push_back([=]{ out->norm_ok[k] = check(test->a, test->b); });
+        }
+        for (size_t k = 0; k < prepared_algorithms.size(); ++k) {
+            auto check = prepared_algorithms[k].second;
+            tasks.push_back([=]{ out->prepared_ok[k] = check(test->a, test->b); });
+        }
+    }
+    RunConcurrently(tasks);
 
     for (size_t t = 0; t < tests.size(); ++t) {
         const auto& test = tests[t];
@@ -307,7 +1369,8 @@ int main() {
         print_vector_summary(test.b, "Вектор B");
 
         /* ── GMP reference ───────────────────────────────────────────────────── */
-        double gmp_exact = ExactDotProductGMP(test.a, test.b);
+        const TestOutcome& outcome = outcomes[t];
+        double gmp_exact = outcome.exact;
         std::cout << YELLOW << "GMP: ";
         if (std::isnan(gmp_exact))         std::cout << "NaN";
         else if (std::isinf(gmp_exact))    std::cout << (gmp_exact > 0 ? "INF" : "-INF");
@@ -316,11 +1379,9 @@ int main() {
         std::cout << RESET << "\n\n";
 
         /* ── ПРОГОН АЛГОРИТМОВ ───────────────────────────────────────────────── */
-        for (const auto& algo : algorithms) {
-            std::feclearexcept(FE_ALL_EXCEPT);
-
-            const std::string& name   = std::get<0>(algo);
-            double result             = std::get<1>(algo)(test.a, test.b);
+        for (size_t k = 0; k < algorithms.size(); ++k) {
+            const std::string& name   = std::get<0>(algorithms[k]);
+            double result             = outcome.results[k];
 
             bool gmp_ok;
             if (std::isnan(result))
@@ -330,12 +1391,12 @@ int main() {
             else
                 gmp_ok = std::memcmp(&result, &gmp_exact, sizeof(double)) == 0;
 
-            bool perm_ok = std::get<2>(algo)(test.a, test.b);
+            bool perm_ok = outcome.perm_ok[k];
 
             /* —— ВЫВОД: № теста, алгоритм, результат, статусы —— */
             std::cout << " #"
                     << std::setw(2) << num << "  "                        // номер теста
-                    << std::left  << std::setw(10) << name                // имя алгоритма
+                    << std::left  << std::setw(11) << name                // имя алгоритма
                     << std::right << std::scientific << std::setprecision(15)
                     << result
                     << "  GMP "  << (gmp_ok  ? GREEN "✓" : RED "✗") << RESET
@@ -343,11 +1404,134 @@ int main() {
                     << '\n';
         }
 
+        /* ── НЕЗАВИСИМОСТЬ ОТ ЧИСЛА ПОТОКОВ ─────────────────────────────────── */
+        std::cout << " Потоки 1/2/3/8:";
+        for (size_t k = 0; k < parallel_algorithms.size(); ++k) {
+            bool same = outcome.threads_ok[k];
+            std::cout << "  " << parallel_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── ОПЕРАНДЫ С ШАГОМ ───────────────────────────────────────────────── */
+        std::cout << " Шаг 2:";
+        for (size_t k = 0; k < strided_algorithms.size(); ++k) {
+            bool same = outcome.strided_ok[k];
+            std::cout << "  " << strided_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── ПОРЦИИ, СЕРИАЛИЗАЦИЯ И СЛИЯНИЕ ─────────────────────────────────── */
+        std::cout << " Порции:";
+        for (size_t k = 0; k < chunked_algorithms.size(); ++k) {
+            bool same = outcome.chunked_ok[k];
+            std::cout << "  " << chunked_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── ШАБЛОННЫЕ ЯДРА ─────────────────────────────────────────────────── */
+        std::cout << " Шаблоны:";
+        for (size_t k = 0; k < policy_algorithms.size(); ++k) {
+            bool same = outcome.policy_ok[k];
+            std::cout << "  " << policy_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── РАЗРЕЖЕННЫЕ ОПЕРАНДЫ ───────────────────────────────────────────── */
+        std::cout << " Разреженные:";
+        for (size_t k = 0; k < sparse_algorithms.size(); ++k) {
+            bool same = outcome.sparse_ok[k];
+            std::cout << "  " << sparse_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── FLOAT И 16-БИТНЫЕ ФОРМАТЫ ──────────────────────────────────────── */
+        std::cout << " Низкая точность:";
+        for (size_t k = 0; k < low_precision_algorithms.size(); ++k) {
+            bool same = outcome.low_precision_ok[k];
+            std::cout << "  " << low_precision_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── МАТРИЦЫ ────────────────────────────────────────────────────────── */
+        std::cout << " Матрицы:";
+        for (size_t k = 0; k < matrix_algorithms.size(); ++k) {
+            bool same = outcome.matrix_ok[k];
+            std::cout << "  " << matrix_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── DOTK ───────────────────────────────────────────────────────────── */
+        std::cout << " DotK, K =";
+        for (size_t k = 0; k < dotk_algorithms.size(); ++k) {
+            bool same = outcome.dotk_ok[k];
+            std::cout << "  " << dotk_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── НОРМЫ И СУММЫ КВАДРАТОВ ────────────────────────────────────────── */
+        std::cout << " Нормы:";
+        for (size_t k = 0; k < norm_algorithms.size(); ++k) {
+            bool same = outcome.norm_ok[k];
+            std::cout << "  " << norm_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
+        /* ── ПОДГОТОВЛЕННЫЙ ОПЕРАНД ─────────────────────────────────────────── */
+        std::cout << " Подготовленный a:";
+        for (size_t k = 0; k < prepared_algorithms.size(); ++k) {
+            bool same = outcome.prepared_ok[k];
+            std::cout << "  " << prepared_algorithms[k].first << " " << (same ? GREEN "✓" : RED "✗") << RESET;
+        }
+        std::cout << '\n';
+
         std::cout << BLUE
                 << "══════════════════════════════════════════════════\n\n"
                 << RESET;
     }
 
+    /* ── ПАКЕТ КОРОТКИХ ВЕКТОРОВ ────────────────────────────────────────────── */
+    std::cout << "Пакет, n = 3/8/16/21/32/64:";
+    bool merge_batch_ok = true, fma_batch_ok = true;
+    for (size_t n : {3, 8, 16, 21, 32, 64}) {
+        merge_batch_ok &= CheckBatch<merge_dot_product_batch, merge_dot_product>(n);
+        fma_batch_ok &= CheckBatch<fma_dot_product_batch, fma_dot_product>(n);
+    }
+    std::cout << "  Merge " << (merge_batch_ok ? GREEN "✓" : RED "✗") << RESET
+              << "  FMA " << (fma_batch_ok ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    bool fixed_ok = CheckFixed<8>() && CheckFixed<16>() && CheckFixed<37>() && CheckFixed<64>();
+    std::cout << "Длина при компиляции, N = 8/16/37/64:  "
+              << (fixed_ok ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    bool gemm_ok = CheckGemmBlocks(1, 1, 1) && CheckGemmBlocks(3, 17, 40)
+                && CheckGemmBlocks(37, 130, 300) && CheckGemmBlocks(70, 5, 600);
+    std::cout << "GEMM по блокам, 3×17×40 … 70×5×600:  "
+              << (gemm_ok ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    bool dotk_ok = true;
+    for (size_t n : {10, 1000, 20000}) {
+        dotk_ok &= CheckDotKConditioned<2>(n) && CheckDotKConditioned<3>(n) && CheckDotKConditioned<4>(n)
+                && CheckDotKConditioned<6>(n) && CheckDotKConditioned<8>(n);
+    }
+    std::cout << "DotK, обусловленность до 2^(53·K):  "
+              << (dotk_ok ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    std::cout << "Нормы на краях диапазона:  "
+              << (CheckNormRanges() ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    std::cout << "Узкий диапазон экспонент:  "
+              << (CheckNarrowWindow() ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    std::cout << "Подготовленный операнд, края диапазона:  "
+              << (CheckPreparedRanges() ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    std::cout << "Асинхронный движок:  "
+              << (CheckEngine() ? GREEN "✓" : RED "✗") << RESET << '\n';
+
+    bool file_ok = true;
+    for (const TestCase& test : tests) file_ok &= CheckVectorFile(test.a, test.b);
+    std::cout << "Файл .dotv (mmap):  " << (file_ok ? GREEN "✓" : RED "✗") << RESET << '\n';
 
+    instrument_export();
     return 0;
 }
\ No newline at end of file